@@ -0,0 +1,107 @@
+/*
+ * Backtrack.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  See Backtrack.h
+ */
+
+#include "Backtrack.h"
+
+namespace SARC {
+
+BacktrackEngine::BacktrackEngine(StateHistory& history) : _history(history)
+{
+	_segmentStart = 0;
+	_segmentDuration = 0;
+	_active = false;
+}
+
+bool BacktrackEngine::Start(RobotMotor& motor, uint32_t nowMicros)
+{
+	_history.EndCurrentState();
+	if (_history.GetHistorySize() == 0) return false;
+
+	// Our own movements must not end up in the history we're replaying.
+	_history.SetRecording(false);
+	_iterator = _history.BacktrackIterator(_history.GetHistorySize());
+	_segmentStart = nowMicros;
+	_active = true;
+	BeginSegment(motor);
+	return _active;
+}
+
+/*
+ * Drives the current State in reverse. States without movement (e.g. the
+ * time spent waiting for the client) are skipped right away, so they don't
+ * cost a pass each.
+ */
+void BacktrackEngine::BeginSegment(RobotMotor& motor)
+{
+	while (_iterator != _history.BacktrackIteratorEnd()
+			&& _iterator->getLeftSpeed() == MotorDefs::neutral
+			&& _iterator->getRightSpeed() == MotorDefs::neutral)
+	{
+		++_iterator;
+	}
+
+	if (_iterator == _history.BacktrackIteratorEnd())
+	{
+		// Back where the history began.
+		_history.Clear();
+		Finish(motor);
+		return;
+	}
+
+	State reversed(*_iterator);
+	_iterator->CopyReverse(reversed);
+	_segmentDuration = _iterator->getDuration();
+	motor.MoveAbsolute(reversed.getLeftSpeed(), reversed.getRightSpeed());
+}
+
+void BacktrackEngine::Update(RobotMotor& motor, uint32_t nowMicros)
+{
+	if (!_active) return;
+	if (nowMicros - _segmentStart < _segmentDuration) return;
+
+	_segmentStart += _segmentDuration;
+	++_iterator; // It's a reverse iterator, so incrementing goes to previous one. ;)
+	BeginSegment(motor);
+}
+
+void BacktrackEngine::Abort(RobotMotor& motor, uint32_t nowMicros)
+{
+	if (!_active) return;
+
+	// Keep only what hasn't been retraced, including the rest of this segment.
+	uint32_t elapsed = nowMicros - _segmentStart;
+	if (elapsed < _segmentDuration)
+	{
+		_iterator->setDuration(_segmentDuration - elapsed);
+		_history.SetCurrent(_iterator);
+	}
+	else
+	{
+		++_iterator;
+		if (_iterator == _history.BacktrackIteratorEnd())
+			_history.Clear();
+		else
+			_history.SetCurrent(_iterator);
+	}
+	Finish(motor);
+}
+
+void BacktrackEngine::Finish(RobotMotor& motor)
+{
+	// Stopped before recording resumes, so the stop isn't recorded either.
+	_active = false;
+	motor.StopMovement();
+	_history.SetRecording(true);
+}
+
+bool BacktrackEngine::IsActive(void)
+{
+	return _active;
+}
+
+} /* namespace SARC */
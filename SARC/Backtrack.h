@@ -0,0 +1,53 @@
+/*
+ * Backtrack.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Return to sender. When the link to the client is lost, the robot can
+ *  retrace its path by replaying the StateHistory backwards: newest State
+ *  first, each with reversed speeds (State::CopyReverse()) for the State's
+ *  recorded duration.
+ *
+ *  The engine never blocks. Update() is called on every pass of the
+ *  scheduler and only checks whether the current segment is over. Segment
+ *  boundaries are computed from the previous boundary rather than from the
+ *  time Update() happened to run, so lateness of one pass doesn't add up
+ *  over the path.
+ *
+ *  Abort() stops immediately, e.g. when a client reconnects. The history
+ *  is trimmed to the part of the path that hasn't been retraced yet, so a
+ *  later backtrack continues from where the robot actually is.
+ */
+
+#ifndef BACKTRACK_H_
+#define BACKTRACK_H_
+
+#include "State.h"
+#include "Motor.h"
+
+namespace SARC {
+
+class BacktrackEngine
+{
+public:
+	BacktrackEngine(StateHistory& history);
+
+	// @return: false if there is nothing to backtrack.
+	bool Start(RobotMotor& motor, uint32_t nowMicros);
+	void Update(RobotMotor& motor, uint32_t nowMicros);
+	void Abort(RobotMotor& motor, uint32_t nowMicros);
+	bool IsActive(void);
+
+private:
+	void BeginSegment(RobotMotor& motor);
+	void Finish(RobotMotor& motor);
+
+	StateHistory& _history;
+	state_reverse_iterator _iterator;
+	uint32_t _segmentStart;
+	unsigned long _segmentDuration;
+	bool _active;
+};
+
+} /* namespace SARC */
+#endif /* BACKTRACK_H_ */
@@ -8,31 +8,178 @@
 #define CONNECTION_CPP_
 
 #include "Connection.h"
+#include <Arduino.h>
 
 namespace SARC {
 
 Connection::Connection()
+#ifdef USE_ETHERNET
+	: _server(port)
+#endif // USE_ETHERNET
 {
+	_current = 0;
+	_rxStart = 0;
+	_rxEnd = 0;
+	_txLength = 0;
+	_txSession = 0;
+	_txSince = 0;
+	_dropped = 0;
+
 	#ifdef USE_ETHERNET
 		Ethernet.begin(mac, ip, gateway, subnet);
-		_server = new EthernetServer(port);
-		_server->begin();
-		_client = _server->available();
+		_server.begin();
+		_controller = CONNECTION_NO_SESSION;
+		_opened = 0;
+		_next = 0;
 	#endif // USE_ETHERNET
 
+	#ifdef USE_UDP
+		_udp.begin(udpPort);
+		_udpActive = false;
+		_udpPending = false;
+		_rxDatagram = false;
+		_startsDatagram = false;
+		_udpPort = 0;
+		_udpSequence = 0;
+		_udpLastReceived = 0;
+	#endif // USE_UDP
+
 	#ifdef USE_XBEE
-		Serial.begin(9600);
+		_controller = 0;
+		_opened = 1;
 	#endif // USE_XBEE
+
+	#ifdef USE_XBEE_API
+		// Replies are broadcast until someone sends something.
+		_address[0] = (uint8_t)(XBEE_BROADCAST >> 8);
+		_address[1] = (uint8_t)XBEE_BROADCAST;
+		_addressLength = 2;
+		_frameId = 0;
+		NegotiateBaudRate();
+	#elif defined(USE_XBEE)
+		Serial.begin(9600);
+	#endif
 }
 
-bool Connection::ClientIsConnected(void)
+#ifdef USE_ETHERNET
+bool Connection::IsOpen(uint8_t session)
 {
-	#ifdef USE_ETHERNET
-		if (!_client.connected())
+	#ifdef USE_UDP
+		if (session == CONNECTION_UDP_SESSION) return _udpActive;
+	#endif
+	return _sessions[session];
+}
+
+void Connection::CloseSession(uint8_t session)
+{
+	_opened &= ~(1 << session);
+	_dropped &= ~(1 << session);
+	if (session == _controller) _controller = CONNECTION_NO_SESSION;
+	if (session == _current) _rxStart = _rxEnd;	// Nobody to answer.
+	if (session == _txSession) _txLength = 0;
+}
+
+void Connection::UpdateSessions(void)
+{
+	for (uint8_t i = 0; i < CONNECTION_TCP_SESSIONS; i++)
+	{
+		if (IsOpen(i) && !_sessions[i].connected())
 		{
-			_client = _server->available();
+			_sessions[i].stop();
+			_sessions[i] = EthernetClient();
+			CloseSession(i);
 		}
-		return _client.connected();
+	}
+
+	#ifdef USE_UDP
+		if (_udpActive && millis() - _udpLastReceived >= CONNECTION_UDP_TIMEOUT)
+		{
+			_udpActive = false;
+			_udpPending = false;
+			CloseSession(CONNECTION_UDP_SESSION);
+		}
+		if (!_udpPending) TakeDatagram();
+	#endif
+
+	// Only returns a client that has data, and not necessarily a new one.
+	EthernetClient client = _server.available();
+	if (!client) return;
+
+	uint8_t free = CONNECTION_NO_SESSION;
+	for (uint8_t i = 0; i < CONNECTION_TCP_SESSIONS; i++)
+	{
+		if (_sessions[i] == client) return;
+		if (!IsOpen(i) && free == CONNECTION_NO_SESSION) free = i;
+	}
+	if (free == CONNECTION_NO_SESSION)
+	{
+		client.stop();
+		return;
+	}
+
+	_sessions[free] = client;
+	_opened |= (1 << free);
+	if (_controller == CONNECTION_NO_SESSION) _controller = free;
+}
+#endif // USE_ETHERNET
+
+#ifdef USE_UDP
+void Connection::OpenUdpSession(void)
+{
+	_udpActive = true;
+	_udpIP = _udp.remoteIP();
+	_udpPort = _udp.remotePort();
+	_opened |= (1 << CONNECTION_UDP_SESSION);
+	if (_controller == CONNECTION_NO_SESSION) _controller = CONNECTION_UDP_SESSION;
+}
+
+/*
+ * Accepts the next datagram if it is newer than the last one accepted, from
+ * the peer holding the session (or opens the session for it). Its commands
+ * are left in the W5100 until Fill() gets to the UDP session; taking the
+ * session here, like a TCP client, lets it be reset before they're handled.
+ * A datagram whose commands don't fit in the receive buffer is accepted, so
+ * the reply carries its sequence number, but never read.
+ */
+void Connection::TakeDatagram(void)
+{
+	// The reply to a dropped datagram has to carry its sequence number.
+	if (_dropped & (1 << CONNECTION_UDP_SESSION)) return;
+
+	int size = _udp.parsePacket();
+	if (size < 2) return;
+
+	if (_udpActive && ((uint32_t)_udp.remoteIP() != (uint32_t)_udpIP || _udp.remotePort() != _udpPort))
+	{
+		return;	// The session belongs to someone else.
+	}
+
+	uint8_t header[2];
+	if (_udp.read(header, 2) != 2) return;
+	uint16_t sequence = header[0] | (header[1] << 8);
+
+	// Serial number arithmetic, so the sequence can wrap.
+	if (_udpActive && (int16_t)(sequence - _udpSequence) <= 0) return;
+
+	if (!_udpActive) OpenUdpSession();
+	_udpSequence = sequence;
+	_udpLastReceived = millis();
+	if (size - 2 > CONNECTION_RX_BUFFER) _dropped |= (1 << CONNECTION_UDP_SESSION);
+	else _udpPending = true;
+}
+#endif // USE_UDP
+
+void Connection::Poll(void)
+{
+	#ifdef USE_ETHERNET
+		UpdateSessions();
+	#endif
+}
+
+bool Connection::ClientIsConnected(void)
+{
+	#ifdef USE_ETHERNET
+		return _controller != CONNECTION_NO_SESSION;
 	#endif
 
 	#ifdef USE_XBEE
@@ -41,51 +188,411 @@ bool Connection::ClientIsConnected(void)
 	#endif
 }
 
-bool Connection::ClientDataAvailable()
+#ifdef USE_ETHERNET
+// Reads what is pending on a session into the receive buffer.
+// @return: The number of bytes read, 0 or less if none.
+int Connection::ReadSession(uint8_t session)
+{
+	#ifdef USE_UDP
+		if (session == CONNECTION_UDP_SESSION)
+		{
+			// TakeDatagram() made sure it fits.
+			if (!_udpPending) return 0;
+			_udpPending = false;
+			_rxDatagram = true;
+			return _udp.read(_rxBuffer, CONNECTION_RX_BUFFER);
+		}
+	#endif
+
+	if (!IsOpen(session)) return 0;
+
+	int available = _sessions[session].available();
+	if (available <= 0) return 0;
+	if (available > CONNECTION_RX_BUFFER) available = CONNECTION_RX_BUFFER;
+
+	return _sessions[session].read(_rxBuffer, available);
+}
+#endif // USE_ETHERNET
+
+/*
+ * Refills the (empty) receive buffer from the next session with data after
+ * the one read last time. On the W5100 that's one size check per session and
+ * one burst read, instead of a couple of SPI transactions per byte.
+ */
+bool Connection::Fill(void)
 {
 	#ifdef USE_ETHERNET
-		if (_client) return _client.available();
+		for (uint8_t i = 0; i < CONNECTION_MAX_SESSIONS; i++)
+		{
+			uint8_t session = (_next + i) % CONNECTION_MAX_SESSIONS;
+			int count = ReadSession(session);
+			if (count <= 0) continue;
+
+			_current = session;
+			_next = (session + 1) % CONNECTION_MAX_SESSIONS;
+			_rxStart = 0;
+			_rxEnd = (uint8_t)count;
+			return true;
+		}
 		return false;
 	#endif
 
-	#ifdef USE_XBEE
-		return Serial.available(); // For now, assume we're connected unless timeout is reached.
+	#ifdef USE_XBEE_API
+		while (Serial.available() > 0)
+		{
+			XBeeParseResult result = _parser.Feed((uint8_t)Serial.read());
+			if (result == xbeeFrameReady && TakeFrame(true)) return true;
+			if (result == xbeeTooLong) TakeFrame(false);
+		}
+		return false;
+	#elif defined(USE_XBEE)
+		// The serial library already buffers; this just empties its buffer.
+		uint8_t count = 0;
+		while (count < CONNECTION_RX_BUFFER && Serial.available() > 0)
+		{
+			_rxBuffer[count++] = (uint8_t)Serial.read();
+		}
+		_rxStart = 0;
+		_rxEnd = count;
+		return count != 0;
 	#endif
 }
 
-/*
- * Please note: This will return '\0' if no data is available! Recommended
- * usage is to call this only when ClientDataAvailable() returns true.
- */
-char Connection::Read()
+uint8_t Connection::Receive(const uint8_t*& data, uint8_t maxLength)
+{
+	if (_rxStart == _rxEnd && !Fill()) return 0;
+
+	#ifdef USE_UDP
+		_startsDatagram = _rxDatagram && _current == CONNECTION_UDP_SESSION;
+		_rxDatagram = false;
+	#endif
+
+	uint8_t count = _rxEnd - _rxStart;
+	if (count > maxLength) count = maxLength;
+	data = _rxBuffer + _rxStart;
+	_rxStart += count;
+	return count;
+}
+
+uint8_t Connection::GetSession(void)
+{
+	return _current;
+}
+
+bool Connection::IsController(void)
+{
+	return _current == _controller;
+}
+
+uint8_t Connection::GetOpenSessions(void)
 {
 	#ifdef USE_ETHERNET
-		if (ClientDataAvailable()) return _client.read();
-		return '\0';
+		uint8_t open = 0;
+		for (uint8_t i = 0; i < CONNECTION_MAX_SESSIONS; i++)
+		{
+			if (IsOpen(i)) open |= (1 << i);
+		}
+		return open;
 	#endif
 
 	#ifdef USE_XBEE
-		return Serial.read();
+		return 1;
 	#endif
 }
 
+bool Connection::TakeDroppedSession(uint8_t& session)
+{
+	for (uint8_t i = 0; i < CONNECTION_MAX_SESSIONS; i++)
+	{
+		if (_dropped & (1 << i))
+		{
+			_dropped &= ~(1 << i);
+			session = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+void Connection::Select(uint8_t session)
+{
+	_current = session;
+}
+
+bool Connection::StartsDatagram(void)
+{
+	#ifdef USE_UDP
+		return _startsDatagram;
+	#else
+		return false;
+	#endif
+}
+
+bool Connection::TakeDeliveryStatus(uint8_t& status)
+{
+	#ifdef USE_XBEE_API
+		if (_statuses.Empty()) return false;
+		status = _statuses.FromNewest(_statuses.Size() - 1);
+		_statuses.PopFront();
+		return true;
+	#else
+		return false;
+	#endif
+}
+
+bool Connection::TakeOpenedSession(uint8_t& session)
+{
+	for (uint8_t i = 0; i < CONNECTION_MAX_SESSIONS; i++)
+	{
+		if (_opened & (1 << i))
+		{
+			_opened &= ~(1 << i);
+			session = i;
+			return true;
+		}
+	}
+	return false;
+}
+
 size_t Connection::PrintLine(const char* string)
+{
+	size_t length = 0;
+	while (string[length] != '\0') length++;
+
+	length = Write((const uint8_t*)string, length);
+	return length + Write((const uint8_t*)"\r\n", 2);
+}
+
+/*
+ * Writes raw bytes, e.g. compact status codes, without a line terminator.
+ * They go to the current session, through the transmit buffer.
+ */
+size_t Connection::Write(const uint8_t* data, size_t length)
 {
 	#ifdef USE_ETHERNET
-		if (ClientIsConnected())
+		if (!IsOpen(_current)) return (size_t)0;
+	#endif
+
+	if (_txLength > 0 && (_txSession != _current || _txLength + length > CONNECTION_TX_BUFFER))
+	{
+		Flush();
+	}
+	if (length > CONNECTION_TX_BUFFER)
+	{
+		Send(_current, data, length);
+		return length;
+	}
+
+	if (_txLength == 0)
+	{
+		_txSession = _current;
+		_txSince = micros();
+	}
+	for (size_t i = 0; i < length; i++)
+	{
+		_txBuffer[_txLength++] = data[i];
+	}
+	return length;
+}
+
+void Connection::Broadcast(const uint8_t* data, size_t length, uint8_t sessions)
+{
+	Flush();
+	#ifdef USE_ETHERNET
+		for (uint8_t i = 0; i < CONNECTION_MAX_SESSIONS; i++)
 		{
-			return _client.println(string);
+			if ((sessions & (1 << i)) && IsOpen(i)) Send(i, data, length);
 		}
-		return (size_t)0;
 	#endif
 
 	#ifdef USE_XBEE
-		return Serial.println((const char *)string);
+		if (sessions & 1) Send(0, data, length);
+	#endif
+}
+
+void Connection::Flush(void)
+{
+	if (_txLength == 0) return;
+	Send(_txSession, _txBuffer, _txLength);
+	_txLength = 0;
+}
+
+void Connection::FlushIfDue(void)
+{
+	if (_txLength > 0 && micros() - _txSince >= CONNECTION_TX_DEADLINE) Flush();
+}
+
+void Connection::Send(uint8_t session, const uint8_t* data, size_t length)
+{
+	#ifdef USE_UDP
+		if (session == CONNECTION_UDP_SESSION)
+		{
+			if (!_udpActive) return;
+			uint8_t header[2] = { (uint8_t)_udpSequence, (uint8_t)(_udpSequence >> 8) };
+			_udp.beginPacket(_udpIP, _udpPort);
+			_udp.write(header, 2);
+			_udp.write(data, length);
+			_udp.endPacket();
+			return;
+		}
 	#endif
+
+	#ifdef USE_ETHERNET
+		if (IsOpen(session)) _sessions[session].write(data, length);
+	#endif
+
+	#ifdef USE_XBEE_API
+		while (length > 0)
+		{
+			uint8_t chunk = (length > XBEE_MAX_PAYLOAD) ? XBEE_MAX_PAYLOAD : (uint8_t)length;
+			SendFrame(data, chunk);
+			data += chunk;
+			length -= chunk;
+		}
+	#elif defined(USE_XBEE)
+		Serial.write(data, length);
+	#endif
+}
+
+#ifdef USE_XBEE_API
+/*
+ * Moves the radio and the UART to XBEE_API_BAUD. The radio may already be
+ * there (if only the Arduino was reset), so that is tried first; otherwise
+ * it is asked at 9600 to change. BD isn't saved in the radio (no ATWR), so a
+ * power cycle puts it back at 9600. If it answers at neither rate, the UART
+ * is left at 9600.
+ */
+void Connection::NegotiateBaudRate(void)
+{
+	uint8_t code = XBEE_API_BAUD_CODE;
+
+	Serial.begin(XBEE_API_BAUD);
+	if (AtCommand("BD", NULL, 0)) return;
+
+	Serial.flush();
+	Serial.begin(XBEE_DEFAULT_BAUD);
+	if (AtCommand("BD", &code, 1))
+	{
+		// The radio answers at the old rate, then changes.
+		Serial.flush();
+		Serial.begin(XBEE_API_BAUD);
+	}
+}
+
+/*
+ * Sends an AT command to the local radio and waits up to XBEE_AT_TIMEOUT
+ * for its reply. Anything else received meanwhile is dropped; this is only
+ * used before any client can be talking.
+ * @return: true if the radio replied OK.
+ */
+bool Connection::AtCommand(const char* command, const uint8_t* value, uint8_t length)
+{
+	XBeeFrameWriter writer(Serial);
+	uint8_t id = NextFrameId();
+
+	writer.Begin(4 + length);
+	writer.Write(XBEE_API_AT_COMMAND);
+	writer.Write(id);
+	writer.Write((uint8_t)command[0]);
+	writer.Write((uint8_t)command[1]);
+	writer.Write(value, length);
+	writer.End();
+
+	uint32_t start = millis();
+	while (millis() - start < XBEE_AT_TIMEOUT)
+	{
+		if (Serial.available() <= 0)
+		{
+			delay(1);
+			continue;
+		}
+		if (_parser.Feed((uint8_t)Serial.read()) != xbeeFrameReady) continue;
+
+		const uint8_t* frame = _parser.GetData();
+		if (_parser.GetLength() >= 5 && frame[0] == XBEE_API_AT_RESPONSE && frame[1] == id)
+		{
+			return frame[4] == XBEE_AT_OK;
+		}
+	}
+	return false;
+}
+
+/*
+ * Handles the frame the parser just completed. Receive packets are copied to
+ * the receive buffer, and their sender becomes the address for replies;
+ * transmit status is queued for TakeDeliveryStatus(). A receive packet that
+ * doesn't fit (or that was too long for the parser, complete = false) is
+ * dropped, and reported so its sender can be told.
+ * @return: true if the receive buffer was filled.
+ */
+bool Connection::TakeFrame(bool complete)
+{
+	const uint8_t* frame = _parser.GetData();
+	uint8_t length = (uint8_t)_parser.GetLength();
+	uint8_t header;
+
+	switch (frame[0])
+	{
+		case XBEE_API_TX_STATUS:
+			if (length >= 3) _statuses.PushBack(frame[2]);
+			return false;
+
+		case XBEE_API_RX_16:
+			_addressLength = 2;
+			header = XBEE_RX_16_HEADER;
+			break;
+
+		case XBEE_API_RX_64:
+			_addressLength = 8;
+			header = XBEE_RX_64_HEADER;
+			break;
+
+		default:
+			return false;
+	}
+
+	if (_parser.GetLength() <= header) return false;
+
+	for (uint8_t i = 0; i < _addressLength; i++)
+	{
+		_address[i] = frame[1 + i];
+	}
+	if (!complete || _parser.GetLength() - header > CONNECTION_RX_BUFFER)
+	{
+		_dropped |= 1;
+		return false;
+	}
+	_rxStart = 0;
+	_rxEnd = length - header;
+	for (uint8_t i = 0; i < _rxEnd; i++)
+	{
+		_rxBuffer[i] = frame[header + i];
+	}
+	return true;
+}
+
+void Connection::SendFrame(const uint8_t* data, uint8_t length)
+{
+	XBeeFrameWriter writer(Serial);
+
+	writer.Begin(1 + 1 + _addressLength + 1 + length);
+	writer.Write(_addressLength == 8 ? XBEE_API_TX_64 : XBEE_API_TX_16);
+	writer.Write(NextFrameId());
+	writer.Write(_address, _addressLength);
+	writer.Write(0);		// Options: acknowledged
+	writer.Write(data, length);
+	writer.End();
+}
+
+// Frame ID 0 would turn off the radio's reply, so it is skipped.
+uint8_t Connection::NextFrameId(void)
+{
+	if (++_frameId == 0) _frameId = 1;
+	return _frameId;
 }
+#endif // USE_XBEE_API
 
 Connection::~Connection() {
-	delete _server;
 }
 
 } /* namespace SARC */
@@ -13,16 +13,72 @@
  *  is the client. That's because the port is opened on the robot and it
  *  listens for incoming connections.
  *
+ *  With Ethernet, up to CONNECTION_MAX_SESSIONS clients can be connected at
+ *  once (the W5100 has 4 sockets). The first client to connect while nobody
+ *  is in control becomes the controller; the rest are observers, which get
+ *  telemetry and can query the robot but not drive it. Observers are not
+ *  promoted when the controller leaves: control goes to the next client to
+ *  connect. Like EthernetServer::available(), a client is only noticed once
+ *  it has sent something. With XBee there is a single session, always in
+ *  control.
+ *
+ *  Input is read in bursts: when the receive buffer is empty, everything
+ *  pending on the next session with data (up to CONNECTION_RX_BUFFER bytes)
+ *  is read in one go, and Receive() hands it out in spans. Sessions take
+ *  turns, so a busy one can't hold up the others. Replies go to the session
+ *  the last span came from; Broadcast() goes to the sessions it is given.
+ *
+ *  Poll() checks the sessions once per pass of loop(); ClientIsConnected()
+ *  just returns what it found, so asking again costs nothing.
+ *
+ *  Output is collected in a transmit buffer, and sent in one write (one TCP
+ *  segment, instead of one for the text and another for the CRLF) when the
+ *  buffer is full, when output for another session comes along, or by
+ *  FlushIfDue() at the end of a pass once it has waited CONNECTION_TX_DEADLINE.
+ *  Broadcast() output isn't buffered, but anything buffered is sent first.
+ *
+ *  With USE_UDP (on top of USE_ETHERNET), commands can also come in as UDP
+ *  datagrams on udpPort, which avoids TCP holding up every later command while
+ *  a lost segment is resent. Each datagram is
+ *  	[sequence number, 2 bytes little endian][commands]
+ *  and is dropped unless its sequence number is newer than the last one
+ *  accepted, so a late or duplicated datagram can't undo a newer command.
+ *  A datagram holds whole frames: StartsDatagram() tells the caller to drop
+ *  any frame the last one left incomplete. One with more commands than fit
+ *  in the receive buffer is dropped without reading it; TakeDroppedSession()
+ *  hands out its session, so the client can be told.
+ *  The UDP peer gets its own session (CONNECTION_UDP_SESSION), with the same
+ *  command handling as TCP. Its socket is one of the W5100's 4, so only 3
+ *  TCP clients can be connected at once. It is taken by the first datagram
+ *  while nobody holds it, and released when nothing has come from that
+ *  address for CONNECTION_UDP_TIMEOUT milliseconds. Poll() takes one
+ *  datagram per pass. Replies go back as datagrams that start with the
+ *  sequence number of the last datagram accepted.
+ *
+ *  With USE_XBEE_API (on top of USE_XBEE), the radio is run in escaped API
+ *  mode instead of transparent mode (see XBee.h). Commands only come from
+ *  receive packets whose checksum is good, so line noise can't turn into
+ *  commands, and replies go back to the radio that sent the last packet.
+ *  A packet with more data than fits in the receive buffer is dropped, and
+ *  reported by TakeDroppedSession() as for UDP.
+ *  At startup the UART is moved from 9600 to XBEE_API_BAUD with the BD
+ *  command. The radio reports whether each packet sent was acknowledged;
+ *  TakeDeliveryStatus() hands those reports to the caller.
  */
 
 #ifndef CONNECTION_H_
 #define CONNECTION_H_
 
+#include "Protocol.h"
+
 //#define USE_ETHERNET	// You should define either USE_ETHERNET or USE_XBEE.
 //#define USE_XBEE
 
 #ifdef USE_ETHERNET
 #include <Ethernet.h>
+#ifdef USE_UDP
+#include <EthernetUdp.h>
+#endif
 
 #ifdef CONNECTION_CPP_
 /************ ETHERNET SHIELD CONFIG ************/
@@ -31,6 +87,9 @@ byte ip[] = { 192, 168, 1, 99 }; // IP address
 byte gateway[] = { 192, 168, 1, 1 }; // Gateway address
 byte subnet[] = { 255, 255, 255, 0 }; // Subnet mask
 unsigned int port = 23; // Port number (Telnet)
+#ifdef USE_UDP
+unsigned int udpPort = 23; // Port number for command datagrams
+#endif
 
 #endif //CONNECTION_CPP_
 
@@ -39,6 +98,10 @@ unsigned int port = 23; // Port number (Telnet)
 #ifdef USE_XBEE
 #include <HardwareSerial.h>
 extern HardwareSerial Serial;
+#ifdef USE_XBEE_API
+#include "XBee.h"
+#include "RingBuffer.h"
+#endif
 
 #ifdef WARN_USING_MESSAGES
 #warning "Using XBee"
@@ -46,6 +109,85 @@ extern HardwareSerial Serial;
 
 #endif // USE_XBEE
 
+#if defined(USE_UDP) && !defined(USE_ETHERNET)
+#error "USE_UDP needs USE_ETHERNET."
+#endif
+
+#ifdef USE_ETHERNET
+	// One W5100 socket each. The UDP session needs a socket of its own.
+	#ifndef CONNECTION_TCP_SESSIONS
+		#ifdef USE_UDP
+			#define CONNECTION_TCP_SESSIONS	3
+		#else
+			#define CONNECTION_TCP_SESSIONS	4
+		#endif
+	#endif
+	#ifdef USE_UDP
+		#define CONNECTION_UDP_SESSION	CONNECTION_TCP_SESSIONS
+		#define CONNECTION_MAX_SESSIONS	(CONNECTION_TCP_SESSIONS + 1)
+	#else
+		#define CONNECTION_MAX_SESSIONS	CONNECTION_TCP_SESSIONS
+	#endif
+	#if CONNECTION_MAX_SESSIONS > 4
+		#error "The W5100 only has 4 sockets."
+	#endif
+#else
+	#define CONNECTION_MAX_SESSIONS	1
+#endif
+#define CONNECTION_NO_SESSION	0xFF
+
+// Big enough for a whole frame (see Protocol.h), as a datagram or an XBee
+// packet has to fit.
+#ifndef CONNECTION_RX_BUFFER
+#define CONNECTION_RX_BUFFER	(PROTOCOL_MAX_PAYLOAD + 3)
+#endif
+#if (defined(USE_UDP) || defined(USE_XBEE_API)) && CONNECTION_RX_BUFFER < PROTOCOL_MAX_PAYLOAD + 3
+#error "CONNECTION_RX_BUFFER must hold a whole frame with USE_UDP or USE_XBEE_API."
+#endif
+
+#ifndef CONNECTION_TX_BUFFER
+#define CONNECTION_TX_BUFFER	48
+#endif
+
+// How long output may wait for more (microseconds). 0 = sent at the end of
+// the pass it was written in.
+#ifndef CONNECTION_TX_DEADLINE
+#define CONNECTION_TX_DEADLINE	0UL
+#endif
+
+#if defined(USE_XBEE_API) && !defined(USE_XBEE)
+#error "USE_XBEE_API needs USE_XBEE."
+#endif
+
+// The radio's UART rate in API mode. 115200 is 2.1% off at 16 MHz, which the
+// XBee copes with; use 57600 (0.8%) if it doesn't.
+#ifndef XBEE_API_BAUD
+#define XBEE_API_BAUD			115200UL
+#endif
+#if XBEE_API_BAUD == 115200UL
+	#define XBEE_API_BAUD_CODE	7		// ATBD value
+#elif XBEE_API_BAUD == 57600UL
+	#define XBEE_API_BAUD_CODE	6
+#elif XBEE_API_BAUD == 38400UL
+	#define XBEE_API_BAUD_CODE	5
+#elif XBEE_API_BAUD == 19200UL
+	#define XBEE_API_BAUD_CODE	4
+#else
+	#error "XBEE_API_BAUD must be 19200, 38400, 57600 or 115200."
+#endif
+#define XBEE_DEFAULT_BAUD		9600UL
+#define XBEE_AT_TIMEOUT			100UL	// Milliseconds to wait for the radio's reply
+#define CONNECTION_STATUS_QUEUE	4		// Delivery reports kept for TakeDeliveryStatus()
+// Frame data kept by the parser: a 64-bit address receive packet that fills
+// the receive buffer.
+#define CONNECTION_XBEE_FRAME	(XBEE_RX_64_HEADER + CONNECTION_RX_BUFFER)
+#define CONNECTION_DELIVERED	0		// Delivery report of a packet that was acknowledged (XBEE_TX_SUCCESS)
+
+// How long the UDP session is kept without a datagram (milliseconds).
+#ifndef CONNECTION_UDP_TIMEOUT
+#define CONNECTION_UDP_TIMEOUT	1000UL
+#endif
+
 namespace SARC {
 
 /*
@@ -56,24 +198,116 @@ public:
 	Connection();
 	virtual ~Connection();
 
+	// Takes in new sessions and drops closed ones. Call once per pass.
+	void Poll(void);
+
+	// @return: true if a controlling client was connected at the last Poll().
 	bool ClientIsConnected(void);
-	bool ClientDataAvailable(void);
-	char Read(void);
+
+	// Hands out up to maxLength received bytes, all from one session. data
+	// points into the receive buffer, and is good until the next call.
+	// @return: The number of bytes, 0 if nothing was received.
+	uint8_t Receive(const uint8_t*& data, uint8_t maxLength);
+
+	// The session the last bytes came from, and whether it is in control.
+	uint8_t GetSession(void);
+	bool IsController(void);
+	// A bit (1 << session) for each session that is open.
+	uint8_t GetOpenSessions(void);
+
+	// Hands out each new session once, so its state can be reset.
+	// @return: false when there are no more.
+	bool TakeOpenedSession(uint8_t& session);
+
+	// Hands out each session whose input was dropped for not fitting in the
+	// receive buffer, once. Select() it to reply.
+	// @return: false when there are no more, and always without USE_UDP or
+	// USE_XBEE_API.
+	bool TakeDroppedSession(uint8_t& session);
+
+	// Sends replies to session, as if the last bytes had come from it.
+	void Select(uint8_t session);
+
+	// @return: true if the bytes last handed out by Receive() are the start
+	// of a datagram. Always false without USE_UDP.
+	bool StartsDatagram(void);
+
+	// Hands out the delivery report (XBEE_TX_*) of each packet sent, oldest
+	// first. Only the last CONNECTION_STATUS_QUEUE are kept.
+	// @return: false when there are no more, and always without USE_XBEE_API.
+	bool TakeDeliveryStatus(uint8_t& status);
 
 	size_t PrintLine(const char*);
+	size_t Write(const uint8_t*, size_t);
+	// Sends to every open session whose bit (1 << session) is set in sessions.
+	void Broadcast(const uint8_t*, size_t, uint8_t sessions);
+
+	// Sends buffered output now.
+	void Flush(void);
+	// Call at the end of every pass of loop().
+	void FlushIfDue(void);
 
 private:
+	bool Fill(void);
+	void Send(uint8_t session, const uint8_t* data, size_t length);
+
+	uint8_t _current;		// Session of the bytes in the receive buffer.
+	uint8_t _controller;
+	uint8_t _opened;		// Bit for each session not yet handed out by TakeOpenedSession().
+	uint8_t _dropped;		// Bit for each session not yet handed out by TakeDroppedSession().
+	uint8_t _rxBuffer[CONNECTION_RX_BUFFER];
+	uint8_t _rxStart;		// Next byte to hand out.
+	uint8_t _rxEnd;
+	uint8_t _txBuffer[CONNECTION_TX_BUFFER];
+	uint8_t _txLength;
+	uint8_t _txSession;
+	uint32_t _txSince;		// micros() when the first buffered byte was written
+
 	#ifdef USE_ETHERNET
-		// TODO: Wrap in better abstraction so all clients have same capabilities/properties.
-		EthernetServer* _server;
-		EthernetClient _client;
+		void UpdateSessions(void);
+		bool IsOpen(uint8_t session);
+		void CloseSession(uint8_t session);
+		int ReadSession(uint8_t session);
+
+		EthernetServer _server;
+		EthernetClient _sessions[CONNECTION_TCP_SESSIONS];
+		uint8_t _next;			// Where the next round-robin read starts.
 	#endif // USE_ETHERNET
 
+	#ifdef USE_UDP
+		void TakeDatagram(void);
+		void OpenUdpSession(void);
+
+		EthernetUDP _udp;
+		bool _udpActive;
+		bool _udpPending;		// An accepted datagram's commands are still to be read.
+		bool _rxDatagram;		// Nothing has been handed out yet of the datagram in the receive buffer.
+		bool _startsDatagram;	// Returned by StartsDatagram().
+		IPAddress _udpIP;		// The peer holding the UDP session.
+		uint16_t _udpPort;
+		uint16_t _udpSequence;	// Of the last datagram accepted.
+		uint32_t _udpLastReceived;		// millis()
+	#endif // USE_UDP
+
 	#ifdef USE_XBEE
 		// Simply using XBee in UART mode, which is the simplest and saves pins.
 		// This should work with anything connected to Arduino Rx/Tx pins.
 	#endif // USE_XBEE
 
+	#ifdef USE_XBEE_API
+		void NegotiateBaudRate(void);
+		bool AtCommand(const char* command, const uint8_t* value, uint8_t length);
+		bool TakeFrame(bool complete);
+		void SendFrame(const uint8_t* data, uint8_t length);
+		uint8_t NextFrameId(void);
+
+		XBeeFrameParser<CONNECTION_XBEE_FRAME> _parser;
+		uint8_t _address[8];		// The radio that sent the last packet.
+		uint8_t _addressLength;		// 2 or 8
+		uint8_t _frameId;
+		RingBuffer<uint8_t, CONNECTION_STATUS_QUEUE> _statuses;
+	#endif // USE_XBEE_API
+
 };	// class Connection
 
 } /* namespace SARC */
@@ -12,8 +12,8 @@
  *
  */
 
+#include <string.h>
 #include "Display.h"
-#include "WString.h"
 
 #ifdef LCD_IS_SERIAL
 //	#include <SoftwareSerial.h>
@@ -21,38 +21,41 @@
 #endif
 
 Display::Display()
+#ifndef LCD_IS_SERIAL
+	// If anyone wants RW support, we should add it here.
+	#ifdef LCD_USE_8_PINS
+		: _lcd(LCD_PIN_RS, LCD_PIN_ENABLE,
+			   LCD_PIN_D0, LCD_PIN_D1, LCD_PIN_D2, LCD_PIN_D3,
+			   LCD_PIN_D4, LCD_PIN_D5, LCD_PIN_D6, LCD_PIN_D7)
+	#else // Assume 4 pins
+		: _lcd(LCD_PIN_RS, LCD_PIN_ENABLE,
+			   LCD_PIN_D4, LCD_PIN_D5, LCD_PIN_D6, LCD_PIN_D7)
+	#endif // LCD_USE_8_PINS
+#endif // Not LCD_IS_SERIAL
 {
 	_currentRow = 0;
 	_currentColumn = 0;
 
+	clearBuffer();
+
+	// We don't know what's on the LCD yet, so make every cell look changed.
+	memset(_shadow, '\0', sizeof(_shadow));
+	_deviceRow = LCD_CURSOR_UNKNOWN;
+	_deviceColumn = LCD_CURSOR_UNKNOWN;
+	_budgetLeft = 0;
+
 #ifdef LCD_IS_SERIAL
 
+	_lastUpdate = micros();
+	_allowance = LCD_TX_ALLOWANCE;
+
 //	_SerialLCD = new SoftwareSerial(LCD_RX_PIN, LCD_TX_PIN);
 //	_SerialLCD->begin(9600);
 	Serial.begin(9600);
 
-	_blankline = String("");
-	for(int i = 0; i < LCD_COLUMN_COUNT; i++)
-		_blankline.concat(' ');
-
-	clearBuffer();
-	SetCursor(_currentRow, _currentColumn);
-
 #else // Not LCD_IS_SERIAL
 
-		// If anyone wants RW support, we should add it here.
-		#ifdef LCD_USE_8_PINS
-
-			*_lcd = LiquidCrystal(LCD_PIN_RS, LCD_PIN_ENABLE,
-								  LCD_PIN_D0, LCD_PIN_D1, LCD_PIN_D2, LCD_PIN_D3,
-								  LCD_PIN_D4, LCD_PIN_D5, LCD_PIN_D6,LCD_PIN_D7);
-
-		#else // Assume 4 pins
-
-			*_lcd = LiquidCrystal(LCD_PIN_RS, LCD_PIN_ENABLE,
-								  LCD_PIN_D4, LCD_PIN_D5, LCD_PIN_D6,LCD_PIN_D7);
-
-		#endif // LCD_USE_8_PINS
+	_lcd.begin(LCD_COLUMN_COUNT, LCD_ROW_COUNT);
 
 #endif // (else not) LCD_IS_SERIAL
 
@@ -60,11 +63,20 @@ Display::Display()
 
 void Display::clearBuffer()
 {
-	for (int row = 0; row < LCD_ROW_COUNT; row++)
-		_buffer[row] = _blankline;
+	memset(_buffer, ' ', sizeof(_buffer));
+	_dirtyRows = (1 << LCD_ROW_COUNT) - 1;
 }
 
+/*
+ * Sets where the next Print() goes. Nothing is sent to the LCD until Update().
+ */
 void Display::SetCursor(uint8_t row, uint8_t col)
+{
+	_currentRow = row;
+	_currentColumn = col;
+}
+
+void Display::MoveDeviceCursor(uint8_t row, uint8_t col)
 {
 	#ifdef LCD_IS_SERIAL
 
@@ -84,21 +96,39 @@ void Display::SetCursor(uint8_t row, uint8_t col)
 		Serial.write(base + col);
 
 	#else
-		_lcd->setCursor(row, col);
+		_lcd.setCursor(col, row);
+	#endif
+
+	_deviceRow = row;
+	_deviceColumn = col;
+}
+
+void Display::WriteDevice(char c)
+{
+	#ifdef LCD_IS_SERIAL
+//		_SerialLCD->write(c);
+		Serial.write(c);
+	#else
+		_lcd.write(c);
 	#endif
 }
 
 void Display::Clear(void)
 {
 	#ifdef LCD_IS_SERIAL
-		clearBuffer();
 //		_SerialLCD->write(0xFE);
 //		_SerialLCD->write(0x51);
 		Serial.write(0xFE);
 		Serial.write(0x51);
 	#else
-		_lcd->clear();
+		_lcd.clear();
 	#endif
+
+	clearBuffer();
+	memset(_shadow, ' ', sizeof(_shadow));
+	_dirtyRows = 0;
+	_deviceRow = 0;
+	_deviceColumn = 0;
 }
 
 void Display::Home(void)
@@ -109,8 +139,11 @@ void Display::Home(void)
 		Serial.write(0xFE);
 		Serial.write(0x46);
 	#else
-		_lcd->home();
+		_lcd.home();
 	#endif
+
+	_deviceRow = 0;
+	_deviceColumn = 0;
 }
 
 void Display::On(void)
@@ -121,7 +154,7 @@ void Display::On(void)
 		Serial.write(0xFE);
 		Serial.write(0x46);
 	#else
-		_lcd->display();
+		_lcd.display();
 	#endif
 }
 
@@ -133,73 +166,178 @@ void Display::Off(void)
 		Serial.write(0xFE);
 		Serial.write(0x42);
 	#else
-		_lcd->noDisplay();
+		_lcd.noDisplay();
 	#endif
 }
 
 void Display::ScrollUp(void)
 {
-	for (int row = 0; row < LCD_ROW_COUNT - 1; row++)
-		_buffer[row] = String(_buffer[row + 1]);
-
-	_buffer[LCD_ROW_COUNT - 1] = _blankline;
+	scrollBuffer();
+}
 
-	Refresh();
+void Display::scrollBuffer(void)
+{
+	memmove(_buffer[0], _buffer[1], (LCD_ROW_COUNT - 1) * LCD_COLUMN_COUNT);
+	memset(_buffer[LCD_ROW_COUNT - 1], ' ', LCD_COLUMN_COUNT);
+	_dirtyRows = (1 << LCD_ROW_COUNT) - 1;
 }
 
+/*
+ * Sends everything that is queued, however long it takes. Only for use
+ * before the control loop starts, e.g. at the end of setup().
+ */
 void Display::Refresh(void)
 {
-	for (int row = 0; row < LCD_ROW_COUNT; row++)
+	Flush(0xFF);
+}
+
+/*
+ * Sends queued changes, but only as many bytes as the LCD can take without
+ * making the caller wait. Call this on every pass of the control loop.
+ *
+ * A serial LCD gets whatever the line has had time to transmit since the last
+ * call, so the HardwareSerial TX buffer never fills up and Serial.write()
+ * never blocks. (Arduino 1.0 has no way to ask how much room is left in that
+ * buffer, so this is worked out from the baud rate.) A parallel LCD blocks on
+ * every byte, so it gets a fixed number of bytes per call.
+ *
+ * @return: true if the LCD is up to date.
+ */
+bool Display::Update(void)
+{
+	if (_dirtyRows == 0) return true;
+
+	#ifdef LCD_IS_SERIAL
+		uint32_t now = micros();
+		unsigned long bytes = (now - _lastUpdate) / LCD_MICROS_PER_BYTE;
+		if (bytes + _allowance >= LCD_TX_ALLOWANCE)
+		{
+			_allowance = LCD_TX_ALLOWANCE;
+			_lastUpdate = now;
+		}
+		else
+		{
+			_allowance += bytes;
+			_lastUpdate += bytes * LCD_MICROS_PER_BYTE;	// Keep the remainder.
+		}
+
+		bool done = Flush(_allowance);
+		_allowance = _budgetLeft;
+		return done;
+	#else
+		return Flush(LCD_BYTES_PER_UPDATE);
+	#endif
+}
+
+/*
+ * Brings the LCD up to date with the buffer, sending at most budget bytes.
+ * For each changed row, only runs of changed cells are sent, each preceded by
+ * a cursor move unless the cursor is already there. Gaps of unchanged cells
+ * that are cheaper to rewrite than to skip (see LCD_CURSOR_MOVE_COST) are
+ * included in the run.
+ *
+ * _shadow is updated as cells go out, so when the budget runs out in the
+ * middle of a row, the next call picks up where this one stopped. Text that
+ * is overwritten before it was sent is never sent at all, so a burst of status
+ * lines costs no more than the lines that are still on screen.
+ *
+ * @return: true if nothing is left to send. _budgetLeft holds the unused budget.
+ */
+bool Display::Flush(uint8_t budget)
+{
+	for (uint8_t row = 0; row < LCD_ROW_COUNT; row++)
 	{
-		SetCursor(row, 0);
-//		_SerialLCD->print(_buffer[row]);
-		Serial.print(_buffer[row]);
+		if (!(_dirtyRows & (1 << row))) continue;
+
+		uint8_t col = 0;
+		while (col < LCD_COLUMN_COUNT)
+		{
+			if (_buffer[row][col] == _shadow[row][col])
+			{
+				col++;
+				continue;
+			}
+
+			// Find the end of this run.
+			uint8_t last = col;
+			for (uint8_t next = col + 1; next < LCD_COLUMN_COUNT && next - last <= LCD_CURSOR_MOVE_COST; next++)
+			{
+				if (_buffer[row][next] != _shadow[row][next]) last = next;
+			}
+
+			uint8_t cost = 0;
+			if (_deviceRow != row || _deviceColumn != col)
+				cost = LCD_CURSOR_MOVE_COST;
+
+			// Not worth moving the cursor to send nothing.
+			if (budget <= cost)
+			{
+				_budgetLeft = budget;
+				return false;
+			}
+
+			bool partial = (budget - cost < last - col + 1);
+			if (partial)
+				last = col + (budget - cost) - 1;
+			budget -= cost + (last - col + 1);
+
+			if (cost != 0)
+				MoveDeviceCursor(row, col);
+
+			for (; col <= last; col++)
+			{
+				WriteDevice(_buffer[row][col]);
+				_shadow[row][col] = _buffer[row][col];
+			}
+
+			// At the end of a row, the controller's cursor wraps to a row that
+			// depends on the model.
+			_deviceColumn = col;
+			if (col >= LCD_COLUMN_COUNT) _deviceRow = LCD_CURSOR_UNKNOWN;
+
+			if (partial)
+			{
+				_budgetLeft = 0;
+				return false;
+			}
+		}
+
+		_dirtyRows &= ~(1 << row);
 	}
+
+	_budgetLeft = budget;
+	return true;
 }
 
+/*
+ * Prints text on a new line. The rest of the line is blanked, so nothing of
+ * the line that was there before remains.
+ */
 void Display::PrintLine(const char* text)
 {
 	// Scroll the display if necessary.
 	if (_currentRow < LCD_ROW_COUNT - 1)
 		_currentRow++;
 	else
-		ScrollUp();
-
-	SetCursor(_currentRow, _currentColumn);
+		scrollBuffer();
 
 	// Pad text with spaces.
-	String paddedText = String(text);
-	paddedText.concat(_blankline);
-	paddedText = paddedText.substring(0, 20);
-
-	// Write text to the display.
-	Print(paddedText);
-}
-
-void Display::PrintLine(const String &text)
-{
-	char buf[text.length() + 1];
-	text.toCharArray(buf, text.length(), 0);
-	PrintLine(buf);
+	char* line = _buffer[_currentRow];
+	uint8_t col = _currentColumn;
+	while (col < LCD_COLUMN_COUNT && *text != '\0')
+		line[col++] = *text++;
+	while (col < LCD_COLUMN_COUNT)
+		line[col++] = ' ';
+	_dirtyRows |= (1 << _currentRow);
 }
 
-void Display::Print(const String &text)
+/*
+ * Prints text at the cursor, cropped to the end of the line.
+ */
+void Display::Print(const char* text)
 {
-	// Crop text if necessary.
-	String croppedText = String(text);
-	if (text.length() + _currentColumn > LCD_COLUMN_COUNT)
-		croppedText = text.substring(0, LCD_COLUMN_COUNT - _currentColumn);
-
-	// Update buffer.
-	for (unsigned int i = 0; i < croppedText.length(); i++)
-		_buffer[_currentRow].setCharAt(_currentColumn + i, croppedText.charAt(i));
-
-	// Output text to device.
-	#ifdef LCD_IS_SERIAL
-//		_SerialLCD->print(croppedText);
-		Serial.print(croppedText);
-	#else
-		_lcd->print(croppedText);
-	#endif
+	char* line = _buffer[_currentRow];
+	for (uint8_t col = _currentColumn; col < LCD_COLUMN_COUNT && *text != '\0'; col++)
+		line[col] = *text++;
+	_dirtyRows |= (1 << _currentRow);
 }
-
@@ -8,9 +8,8 @@
 #ifndef DISPLAY_H_
 #define DISPLAY_H_
 
-#include "WString.h"
-#include "Print.h"
-
+#include <stdint.h>
+
 //#define USE_LCD
 
 /* Use LCD_IS_SERIAL if you have a serial LCD. Right now, we only support this model:
@@ -30,6 +29,8 @@
 #define LCD_RX_PIN 			4
 #define LCD_TX_PIN 			5		// You only need to set this, baud rate and row count.
 #define LCD_BAUD_RATE		9600
+#define LCD_MICROS_PER_BYTE	(10000000UL / LCD_BAUD_RATE)	// Start + 8 data + stop bits
+#define LCD_TX_ALLOWANCE	16		// Most bytes Update() queues at once. Must fit the 64 byte TX buffer.
 #define LCD_ROW_COUNT		4		// TODO: Implement a better way to handle this.
 #define LCD_COLUMN_COUNT	20
 
@@ -39,6 +40,7 @@
 
 #define LCD_ROW_COUNT		2		// TODO: Implement merge of this with same mnemonic above.
 #define LCD_COLUMN_COUNT	20		// TODO: And this one.
+#define LCD_BYTES_PER_UPDATE	4	// Each byte blocks for about 40us, so keep this small.
 /*
  * For details on hooking up your LCD, see the LiquidCrystal documentation at:
  * 			http://arduino.cc/en/Reference/LiquidCrystalConstructor
@@ -69,9 +71,22 @@
 
 #endif // LCD_IS_SERIAL
 
+// Moving the cursor costs this many bytes (0xFE 0x45 position on the serial
+// LCD). Runs of unchanged cells shorter than this are simply rewritten.
+#define LCD_CURSOR_MOVE_COST	3
+#define LCD_CURSOR_UNKNOWN		0xFF
 
 /*
  * Encapsulation of display, for connecting an LCD.
+ *
+ * Neither the serial LCD nor the HD44780 (LiquidCrystal) controller can
+ * scroll vertically, so ScrollUp() is done in the buffer. The diff in
+ * Update() keeps that cheap when lines repeat, e.g. "Accelerating." for
+ * every 'w', because rows that already match cost nothing.
+ *
+ * Print() and PrintLine() only write to the buffer, so they take the same few
+ * microseconds whether or not an LCD is attached. The buffer is the output
+ * queue: Update() sends a little of it at a time, from the control loop.
  */
 class Display
 {
@@ -85,10 +100,10 @@ public:
 	void On(void);
 	void Off(void);
 	void SetCursor(uint8_t row, uint8_t col);
-    void Print(const String &text);
+    void Print(const char *);
     void PrintLine(const char *);
-    void PrintLine(const String &);
     void ScrollUp(void);
+    bool Update(void);
     void Refresh(void);
 
 private:
@@ -96,15 +111,31 @@ private:
     uint8_t _currentRow;
     uint8_t _currentColumn;
 
+    // _buffer is what should be on the screen, _shadow is what the LCD actually
+    // shows. Update() only sends the cells that differ. _dirtyRows has one bit
+    // per row that may differ, so unchanged rows aren't even compared.
+    // Rows are fixed size and not null terminated. Nothing is allocated on the
+    // heap, no matter how much is printed.
+	char _buffer[LCD_ROW_COUNT][LCD_COLUMN_COUNT];
+	char _shadow[LCD_ROW_COUNT][LCD_COLUMN_COUNT];
+	uint8_t _dirtyRows;
+	uint8_t _deviceRow;			// Where the LCD's cursor is. LCD_CURSOR_UNKNOWN if we can't tell.
+	uint8_t _deviceColumn;
+	uint8_t _budgetLeft;		// Set by Flush()
+	void clearBuffer();
+	void scrollBuffer();
+	bool Flush(uint8_t budget);
+	void MoveDeviceCursor(uint8_t row, uint8_t col);
+	void WriteDevice(char c);
+
 	#ifdef LCD_IS_SERIAL
+	uint32_t _lastUpdate;		// micros() up to which _allowance has been credited
+	uint8_t _allowance;			// Bytes that can be written without blocking
 //	SoftwareSerial* _SerialLCD;
-	String _buffer[LCD_ROW_COUNT];
-	String _blankline;
-	void clearBuffer();
 
 	#else
 
-	LiquidCrystal* _lcd;
+	LiquidCrystal _lcd;		// A member, so nothing is allocated on the heap.
 
 	#endif
 };
@@ -0,0 +1,107 @@
+/*
+ * LoopStats.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  See LoopStats.h
+ */
+
+#include "LoopStats.h"
+#include "Protocol.h"
+
+namespace SARC {
+
+// Counts stop at their maximum instead of wrapping.
+static inline void Count(unsigned long& counter)
+{
+	if (counter != 0xFFFFFFFFUL) counter++;
+}
+
+LoopStats::LoopStats(unsigned long budgetMicros)
+{
+	_budget = budgetMicros;
+	_lastMark = 0;
+	_started = false;
+	Reset();
+}
+
+void LoopStats::Mark(uint32_t now)
+{
+	uint32_t duration = now - _lastMark;
+	_lastMark = now;
+
+	// The first call only starts the clock.
+	if (!_started)
+	{
+		_started = true;
+		return;
+	}
+
+	Count(_passes);
+	Count(_buckets[Bucket(duration)]);
+	if (duration > _maxDuration) _maxDuration = duration;
+	if (duration > _budget) Count(_overBudget);
+}
+
+/*
+ * Finds the highest bit set without a 32-bit shift per bit, which is slow
+ * on AVR: at most one 8-bit shift, then single bit shifts of a 16-bit value.
+ */
+uint8_t LoopStats::Bucket(unsigned long duration)
+{
+	if (duration >> 15) return LOOP_STATS_BUCKETS - 1;
+
+	uint16_t value = (uint16_t)duration;
+	uint8_t bucket = 0;
+	if (value & 0xFF00)
+	{
+		value >>= 8;
+		bucket = 8;
+	}
+	while (value > 1)
+	{
+		value >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+void LoopStats::Reset(void)
+{
+	_passes = 0;
+	_maxDuration = 0;
+	_overBudget = 0;
+	for (uint8_t i = 0; i < LOOP_STATS_BUCKETS; i++)
+	{
+		_buckets[i] = 0;
+	}
+}
+
+void LoopStats::Dump(uint8_t* buffer)
+{
+	buffer = PutLong(buffer, _passes);
+	buffer = PutLong(buffer, _maxDuration);
+	buffer = PutLong(buffer, _overBudget);
+	buffer = PutLong(buffer, _budget);
+	for (uint8_t i = 0; i < LOOP_STATS_BUCKETS; i++)
+	{
+		buffer = PutLong(buffer, _buckets[i]);
+	}
+}
+
+unsigned long LoopStats::GetPasses(void)
+{
+	return _passes;
+}
+
+unsigned long LoopStats::GetMaxDuration(void)
+{
+	return _maxDuration;
+}
+
+unsigned long LoopStats::GetOverBudget(void)
+{
+	return _overBudget;
+}
+
+} /* namespace SARC */
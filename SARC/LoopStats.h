@@ -0,0 +1,64 @@
+/*
+ * LoopStats.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Timing of every pass of loop(), cheap enough to leave enabled on the
+ *  robot. Mark() is called once at the start of each pass and records the
+ *  time since the previous one (so one call to the clock per pass), in:
+ *  	A log2 histogram - bucket n counts passes of 2^n to 2^(n+1) - 1
+ *  	                   microseconds (bucket 0 also counts 0). The last
+ *  	                   bucket counts everything longer.
+ *  	The longest pass.
+ *  	The number of passes longer than the budget.
+ *
+ *  Dump() writes all of it in the compact binary layout below, for the
+ *  CLOOP_STATS reply (see Protocol.h). Every field is little-endian:
+ *
+ *  	[PASSES:4] [MAX:4] [OVER BUDGET:4] [BUDGET:4] [BUCKET 0:4] ... [BUCKET 15:4]
+ *
+ *  Counts stop at their maximum instead of wrapping.
+ */
+
+#ifndef LOOPSTATS_H_
+#define LOOPSTATS_H_
+
+#include <stdint.h>
+
+#define LOOP_STATS_BUCKETS		16		// The last one is 32768 microseconds and up.
+#define LOOP_STATS_DUMP_SIZE	(4 * (4 + LOOP_STATS_BUCKETS))
+
+namespace SARC {
+
+class LoopStats
+{
+public:
+	LoopStats(unsigned long budgetMicros);
+
+	// Call at the start of every pass, with the current time in microseconds.
+	void Mark(uint32_t now);
+
+	// Clears the statistics. The pass in progress is still counted.
+	void Reset(void);
+
+	// Writes LOOP_STATS_DUMP_SIZE bytes.
+	void Dump(uint8_t* buffer);
+
+	unsigned long GetPasses(void);
+	unsigned long GetMaxDuration(void);
+	unsigned long GetOverBudget(void);
+
+private:
+	static uint8_t Bucket(unsigned long duration);
+
+	unsigned long _budget;
+	uint32_t _lastMark;
+	bool _started;
+	unsigned long _passes;
+	unsigned long _maxDuration;
+	unsigned long _overBudget;
+	unsigned long _buckets[LOOP_STATS_BUCKETS];
+};
+
+} /* namespace SARC */
+#endif /* LOOPSTATS_H_ */
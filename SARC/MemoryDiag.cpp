@@ -0,0 +1,180 @@
+/*
+ * MemoryDiag.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  See MemoryDiag.h
+ */
+
+#include "MemoryDiag.h"
+#include "Protocol.h"
+
+/*
+ * Platform layer:
+ * 	STACK_POINTER()	- the current stack pointer.
+ * 	StackEnd()		- where the stack starts (it grows down from here).
+ * 	StackLimit()	- the lowest address the stack may grow to.
+ * 	HeapUsed()		- bytes in the heap.
+ */
+#ifdef SARC_HOST
+
+#include "HostHal.h"
+
+#define STACK_POINTER()	((uint8_t*)__builtin_frame_address(0))
+
+static uint8_t* hostStackEnd = 0;	// The top of the area PaintStack() allocated
+
+static uint8_t* StackEnd(void)
+{
+	return hostStackEnd;
+}
+
+static uint8_t* StackLimit(void)
+{
+	return hostStackEnd - HOST_STACK_PAINT;
+}
+
+static unsigned long HeapUsed(void)
+{
+	return HostHeapUsed();
+}
+
+#else
+
+#include <avr/io.h>
+
+extern char __heap_start;
+extern char* __brkval;		// Set by malloc(). 0 until the first allocation.
+
+#define STACK_POINTER()	((uint8_t*)SP)
+
+static uint8_t* StackEnd(void)
+{
+	return (uint8_t*)RAMEND;
+}
+
+static uint8_t* StackLimit(void)
+{
+	return (uint8_t*)(__brkval != 0 ? __brkval : &__heap_start);
+}
+
+static unsigned long HeapUsed(void)
+{
+	return (unsigned long)(StackLimit() - (uint8_t*)&__heap_start);
+}
+
+#endif // SARC_HOST
+
+namespace SARC {
+
+uint8_t* MemoryDiag::_paintStart = 0;
+uint8_t* MemoryDiag::_paintEnd = 0;
+unsigned int MemoryDiag::_heapHighWater = 0;
+
+/*
+ * Paints from the top of the heap to just below the current stack frame.
+ * volatile, so the compiler can't decide the stores are pointless.
+ *
+ * On the host, everything below the stack pointer may be in use (e.g. by a
+ * signal handler), so the paint goes on an area allocated on this frame
+ * instead. It is below the caller's frame, so deeper calls made after this
+ * returns run over it just as they would over the free RAM on the robot.
+ */
+void MemoryDiag::PaintStack(void)
+{
+	#ifdef SARC_HOST
+		uint8_t* area = (uint8_t*)__builtin_alloca(HOST_STACK_PAINT);
+		hostStackEnd = area + HOST_STACK_PAINT;
+		uint8_t* end = hostStackEnd;
+	#else
+		uint8_t* end = STACK_POINTER() - MEMORY_PAINT_MARGIN;
+	#endif
+
+	volatile uint8_t* p = StackLimit();
+
+	_paintStart = (uint8_t*)p;
+	_paintEnd = end;
+	while (p < end) *p++ = MEMORY_PAINT;
+	Sample();
+}
+
+void MemoryDiag::Sample(void)
+{
+	unsigned int heapUsed = Clamp16(HeapUsed());
+	if (heapUsed > _heapHighWater) _heapHighWater = heapUsed;
+}
+
+/*
+ * Scans up from the top of the heap (the heap may have grown into the paint
+ * since it was applied) for the first byte that isn't paint.
+ */
+uint8_t* MemoryDiag::LowestTouched(void)
+{
+	if (_paintEnd == 0) return STACK_POINTER();
+
+	volatile uint8_t* p = StackLimit();
+	if (p < _paintStart) p = _paintStart;
+	while (p < _paintEnd && *p == MEMORY_PAINT) p++;
+	return (uint8_t*)p;
+}
+
+unsigned int MemoryDiag::GetFree(void)
+{
+	return Clamp16(STACK_POINTER() - StackLimit());
+}
+
+unsigned int MemoryDiag::GetStackUsed(void)
+{
+	return Clamp16(StackEnd() - LowestTouched());
+}
+
+unsigned int MemoryDiag::GetMinFree(void)
+{
+	return Clamp16(LowestTouched() - StackLimit());
+}
+
+unsigned int MemoryDiag::GetHeapUsed(void)
+{
+	return Clamp16(HeapUsed());
+}
+
+unsigned int MemoryDiag::GetHeapHighWater(void)
+{
+	Sample();
+	return _heapHighWater;
+}
+
+void MemoryDiag::Dump(uint8_t* buffer)
+{
+	buffer = PutInt(buffer, GetFree());
+	buffer = PutInt(buffer, GetStackUsed());
+	buffer = PutInt(buffer, GetMinFree());
+	buffer = PutInt(buffer, GetHeapUsed());
+	buffer = PutInt(buffer, GetHeapHighWater());
+}
+
+// Appends a label and a number, without pulling in sprintf().
+static char* Append(char* text, const char* label, unsigned int value)
+{
+	char digits[5];
+	uint8_t count = 0;
+
+	while (*label) *text++ = *label++;
+	do
+	{
+		digits[count++] = '0' + value % 10;
+		value /= 10;
+	} while (value != 0);
+	while (count > 0) *text++ = digits[--count];
+	return text;
+}
+
+void MemoryDiag::Describe(char* text)
+{
+	text = Append(text, "F:", GetFree());
+	text = Append(text, " S:", GetStackUsed());
+	text = Append(text, " H:", GetHeapHighWater());
+	*text = '\0';
+}
+
+} /* namespace SARC */
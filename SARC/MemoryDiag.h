@@ -0,0 +1,71 @@
+/*
+ * MemoryDiag.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  RAM diagnostics. An Uno has 2 KB of RAM shared by static data, the heap
+ *  (which grows up) and the stack (which grows down), and nothing stops
+ *  them from running into each other. This reports how close they came:
+ *
+ *  	Free       - bytes between the top of the heap and the stack pointer,
+ *  	             right now.
+ *  	Stack used - the deepest the stack has been since PaintStack(). The
+ *  	             unused RAM is filled with MEMORY_PAINT at boot, and
+ *  	             StackUsed() looks for the lowest byte that was overwritten.
+ *  	Min free   - the part of the painted RAM that was never touched.
+ *  	Heap used  - the size of the heap (up to the allocator's break), now
+ *  	             and the largest seen by Sample().
+ *
+ *  On the host build the heap numbers come from the counting allocator in
+ *  host/HostMemory.cpp, and HOST_STACK_PAINT bytes allocated on the stack by
+ *  PaintStack() stand in for the free RAM.
+ *
+ *  Scanning the paint takes about a millisecond on an Uno, so it is only
+ *  done when a report is asked for.
+ */
+
+#ifndef MEMORYDIAG_H_
+#define MEMORYDIAG_H_
+
+#include <stdint.h>
+
+#define MEMORY_PAINT			0xC5
+#define MEMORY_PAINT_MARGIN		32		// Bytes below the stack pointer left alone by PaintStack()
+#define MEMORY_DIAG_DUMP_SIZE	10
+#define MEMORY_DIAG_TEXT_SIZE	24		// Including the terminator
+
+namespace SARC {
+
+class MemoryDiag
+{
+public:
+	// Call first thing in setup().
+	static void PaintStack(void);
+
+	// Updates the heap high-water mark. Cheap enough for every pass of loop().
+	static void Sample(void);
+
+	static unsigned int GetFree(void);
+	static unsigned int GetStackUsed(void);
+	static unsigned int GetMinFree(void);
+	static unsigned int GetHeapUsed(void);
+	static unsigned int GetHeapHighWater(void);
+
+	// Writes MEMORY_DIAG_DUMP_SIZE bytes, for the CMEMORY_STATUS reply (see
+	// Protocol.h). Little-endian 16-bit values:
+	// [FREE:2] [STACK USED:2] [MIN FREE:2] [HEAP USED:2] [HEAP HIGH WATER:2]
+	static void Dump(uint8_t* buffer);
+
+	// Writes a line for the LCD, e.g. "F:812 S:640 H:0".
+	static void Describe(char* text);
+
+private:
+	static uint8_t* LowestTouched(void);
+
+	static uint8_t* _paintStart;
+	static uint8_t* _paintEnd;
+	static unsigned int _heapHighWater;
+};
+
+} /* namespace SARC */
+#endif /* MEMORYDIAG_H_ */
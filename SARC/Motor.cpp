@@ -10,7 +10,6 @@
 #include "Display.h"
 #include "State.h"
 #include "MotorDefs.h"
-#include <Servo.h>
 #include <WString.h>
 #include <Arduino.h>
 #include "Motor.h"
@@ -20,8 +19,10 @@
 	extern HardwareSerial Serial;
 #endif // DEBUG
 
-extern unsigned long lastMoveTime;
-//extern SARC::StateHistory *stateHistory;
+extern uint32_t lastMoveTime;
+#ifdef USE_BACKTRACK
+extern SARC::StateHistory stateHistory;
+#endif
 
 namespace SARC {
 
@@ -29,28 +30,27 @@ namespace SARC {
 #define max(a,b) ((a)>(b)?(a):(b))
 
 /*
- * @param leftPin The pin number connected to the speed control of your left servo. If using AFMotors, this is ignored.
+ * @param leftPin The pin number connected to the speed control of your left servo. If using AFMotors, this is the motor number.
  *
- * @param rightPin The pin number connected to the speed control of your right servo. If using AFMotors, this is ignored.
+ * @param rightPin The pin number connected to the speed control of your right servo. If using AFMotors, this is the motor number.
  */
-Motor::Motor(unsigned int leftPin, unsigned int rightPin) {
+template <class Driver>
+Motor<Driver>::Motor(unsigned int leftPin, unsigned int rightPin)
+	: _driver(leftPin, rightPin)
+{
 	_isMoving = false;
 	_delta = DELTA;
-#ifdef USE_SERVOS
-	_leftTrackServo = new Servo();
-	_rightTrackServo = new Servo();
-	// init servos
-#ifdef USE_LCD
-//	display->PrintLine("Init servos.");
-#endif
-	_leftTrackServo->attach((int) leftPin);
-	_rightTrackServo->attach((int) rightPin);
-#endif // USE_SERVOS
-
-	#ifdef USE_DC_MOTORS
-		_leftMotor = new AF_DCMotor(AF_MOTOR_LEFT, AF_MOTOR_SPEED);
-		_rightMotor = new AF_DCMotor(AF_MOTOR_RIGHT, AF_MOTOR_SPEED);
-	#endif //USE_DC_MOTORS
+	_leftSpeed = Driver::neutral;
+	_rightSpeed = Driver::neutral;
+	_leftActualSpeed = Driver::ToActual(Driver::neutral);
+	_rightActualSpeed = Driver::ToActual(Driver::neutral);
+	_committedLeftSpeed = 0;
+	_committedRightSpeed = 0;
+	_committedLeftReverse = false;
+	_committedRightReverse = false;
+	_forceWrite = true;
+	_writesCommitted = 0;
+	_writesSkipped = 0;
 }
 
 /*
@@ -59,13 +59,14 @@ Motor::Motor(unsigned int leftPin, unsigned int rightPin) {
  * actually moved. (Unless you call SetSpeed() and Move() directly, in which case the
  * relative values are *not* applied.)
  */
-void Motor::ValidateSpeeds()
+template <class Driver>
+void Motor<Driver>::ValidateSpeeds()
 {
-	if (_leftSpeed > (unsigned int)forward) _leftSpeed = forward;
-	if (_leftSpeed < (unsigned int)minimum) _leftSpeed = minimum;
+	if (_leftSpeed > (unsigned int)Driver::forward) _leftSpeed = Driver::forward;
+	if (_leftSpeed < (unsigned int)Driver::minimum) _leftSpeed = Driver::minimum;
 
-	if (_rightSpeed > (unsigned int)forward) _rightSpeed = forward;
-	if (_rightSpeed < (unsigned int)minimum) _rightSpeed = minimum;
+	if (_rightSpeed > (unsigned int)Driver::forward) _rightSpeed = Driver::forward;
+	if (_rightSpeed < (unsigned int)Driver::minimum) _rightSpeed = Driver::minimum;
 }
 
 /*
@@ -73,26 +74,16 @@ void Motor::ValidateSpeeds()
  * Basically, if you're controlling motors with MotorDefs forward or reverse, call MoveRelative.
  * If you're setting the speeds from StateHistory (or otherwise setting a known value), call Move.
  */
-void Motor::MoveRelative()
+template <class Driver>
+void Motor<Driver>::MoveRelative()
 {
 //#ifdef DEBUG
 //	Serial.print("MoveRelative() ");
 //#endif
 	ValidateSpeeds();
 
-#ifdef USE_DC_MOTORS // This is only tested with USE_AF_MOTORS.
-	if (_leftSpeed <= reverse)
-		_leftActualSpeed = (unsigned int) map(_leftSpeed, reverse, reverse - relative, minimum, maximum);
-	else
-		_leftActualSpeed = (unsigned int) map(_leftSpeed, forward - relative, forward, minimum, maximum);
-	if (_rightSpeed <= reverse)
-		_rightActualSpeed = (unsigned int) map(_rightSpeed, reverse, reverse - relative, minimum, maximum);
-	else
-		_rightActualSpeed = (unsigned int) map(_rightSpeed, forward - relative, forward, minimum, maximum);
-#else
-	_leftActualSpeed = _leftSpeed;
-	_rightActualSpeed = _rightSpeed;
-#endif
+	_leftActualSpeed = Driver::ToActual(_leftSpeed);
+	_rightActualSpeed = Driver::ToActual(_rightSpeed);
 	Move();
 
 //#ifdef DEBUG
@@ -104,7 +95,8 @@ void Motor::MoveRelative()
  * This method sets the relative speed of the left and right motors.
  * This method could be used for moving forward or reverse, if the speeds are the same.
  */
-void Motor::Turn(unsigned int newLeftSpeed, unsigned int newRightSpeed)
+template <class Driver>
+void Motor<Driver>::Turn(unsigned int newLeftSpeed, unsigned int newRightSpeed)
 {
 #ifdef DEBUG
 	Serial.print("Turn() - newLeftSpeed = "); Serial.print(newLeftSpeed);
@@ -121,10 +113,11 @@ void Motor::Turn(unsigned int newLeftSpeed, unsigned int newRightSpeed)
  * speed is *decreased* by this amount and the right motor speed is *increased*
  * by it.
  */
-void Motor::TurnLeft(unsigned int delta)
+template <class Driver>
+void Motor<Driver>::TurnLeft(unsigned int delta)
 {
 	_rightSpeed += delta;
-	if (delta >= _leftSpeed) _leftSpeed = reverse - relative;
+	if (delta >= _leftSpeed) _leftSpeed = Driver::reverse - Driver::relative;
 	else _leftSpeed -= delta;
 	ValidateSpeeds();
 #ifdef DEBUG
@@ -138,10 +131,11 @@ void Motor::TurnLeft(unsigned int delta)
  * speed is *decreased* by this amount and the left motor speed is *increased*
  * by it.
  */
-void Motor::TurnRight(unsigned int delta)
+template <class Driver>
+void Motor<Driver>::TurnRight(unsigned int delta)
 {
 	_leftSpeed += delta;
-	if (delta >= _rightSpeed) _rightSpeed = reverse - relative;
+	if (delta >= _rightSpeed) _rightSpeed = Driver::reverse - Driver::relative;
 	else _rightSpeed -= delta;
 	ValidateSpeeds();
 #ifdef DEBUG
@@ -162,8 +156,8 @@ void Motor::TurnRight(unsigned int delta)
  * You can call it if you like, but be aware that calling the "MoveForward" and other methods will
  * override these values the first time they're called.
  */
-void Motor::SetSpeeds(unsigned int newLeftSpeed =neutral,
-		unsigned int newRightSpeed = neutral)
+template <class Driver>
+void Motor<Driver>::SetSpeeds(unsigned int newLeftSpeed, unsigned int newRightSpeed)
 {
 //#ifdef DEBUG
 //	Serial.print("SetSpeeds() ");
@@ -174,7 +168,25 @@ void Motor::SetSpeeds(unsigned int newLeftSpeed =neutral,
 	Move();
 }
 
-void Motor::AccelerateForward(unsigned int delta)
+/*
+ * Sets the logical (MotorDefs) speed of both tracks in one step. Unlike SetSpeeds(),
+ * the tracked speeds are updated and the relative is applied, so this behaves like
+ * any of the "Accelerate" methods - just without the accumulation.
+ */
+template <class Driver>
+void Motor<Driver>::MoveAbsolute(unsigned int newLeftSpeed, unsigned int newRightSpeed)
+{
+#ifdef DEBUG
+	Serial.print("MoveAbsolute() - newLeftSpeed = "); Serial.print(newLeftSpeed);
+	Serial.print(", newRightSpeed = "); Serial.println(newRightSpeed);
+#endif
+	_leftSpeed = newLeftSpeed;
+	_rightSpeed = newRightSpeed;
+	MoveRelative();
+}
+
+template <class Driver>
+void Motor<Driver>::AccelerateForward(unsigned int delta)
 {
 #ifdef DEBUG
 	Serial.print("AccelerateForward () - delta = "); Serial.println(delta);
@@ -183,7 +195,8 @@ void Motor::AccelerateForward(unsigned int delta)
 	MoveForward();
 }
 
-void Motor::AccelerateReverse(unsigned int delta)
+template <class Driver>
+void Motor<Driver>::AccelerateReverse(unsigned int delta)
 {
 #ifdef DEBUG
 	Serial.print("AccelerateReverse () - delta = "); Serial.println(delta);
@@ -192,43 +205,47 @@ void Motor::AccelerateReverse(unsigned int delta)
 	MoveReverse();
 }
 
-void Motor::MoveForwardFullSpeed(void)
+template <class Driver>
+void Motor<Driver>::MoveForwardFullSpeed(void)
 {
 #ifdef DEBUG
 	Serial.println("MoveForwardFullSpeed ()");
 #endif
-	_leftSpeed = forward;
-	_rightSpeed = forward;
+	_leftSpeed = Driver::forward;
+	_rightSpeed = Driver::forward;
 	MoveRelative();
 }
 
-void Motor::MoveReverseFullSpeed(void)
+template <class Driver>
+void Motor<Driver>::MoveReverseFullSpeed(void)
 {
 #ifdef DEBUG
 	Serial.println("MoveReverse ()");
 #endif
-	_leftSpeed = reverse - relative;
-	_rightSpeed = reverse - relative;
+	_leftSpeed = Driver::reverse - Driver::relative;
+	_rightSpeed = Driver::reverse - Driver::relative;
 	MoveRelative();
 }
 
-void Motor::TurnRightFullSpeed(void)
+template <class Driver>
+void Motor<Driver>::TurnRightFullSpeed(void)
 {
 //#ifdef DEBUG
 //	Serial.println("TurnRightFullSpeed ()");
 //#endif
-	_leftSpeed = forward;
-	_rightSpeed = reverse - relative;
+	_leftSpeed = Driver::forward;
+	_rightSpeed = Driver::reverse - Driver::relative;
 	MoveRelative();
 }
 
-void Motor::TurnLeftFullSpeed(void)
+template <class Driver>
+void Motor<Driver>::TurnLeftFullSpeed(void)
 {
 //#ifdef DEBUG
 //	Serial.println("TurnLeftFullSpeed ()");
 //#endif
-	_leftSpeed = reverse - relative;
-	_rightSpeed = forward;
+	_leftSpeed = Driver::reverse - Driver::relative;
+	_rightSpeed = Driver::forward;
 	MoveRelative();
 }
 
@@ -237,13 +254,14 @@ void Motor::TurnLeftFullSpeed(void)
  * Note that if the motor has a "braking" mode (as some servos and steppers do),
  * you should call Brake() instead.
  */
-void Motor::StopMovement(void)
+template <class Driver>
+void Motor<Driver>::StopMovement(void)
 {
 //	#ifdef DEBUG
 //		Serial.println("StopMovement ()");
 //	#endif
-	_leftSpeed = neutral;
-	_rightSpeed = neutral;
+	_leftSpeed = Driver::neutral;
+	_rightSpeed = Driver::neutral;
 	MoveRelative();
 }
 
@@ -257,11 +275,12 @@ void Motor::StopMovement(void)
  * so that the next call to one of the movement methods will accelerate from "stopped",
  * not from "brake" because brake is outside the normal operating range.
  */
-void Motor::Brake(void)
+template <class Driver>
+void Motor<Driver>::Brake(void)
 {
-	_leftSpeed = neutral;
-	_rightSpeed = neutral;
-	SetSpeeds(brake, brake);
+	_leftSpeed = Driver::neutral;
+	_rightSpeed = Driver::neutral;
+	SetSpeeds(Driver::brake, Driver::brake);
 }
 
 /*
@@ -269,31 +288,77 @@ void Motor::Brake(void)
  * currently the highest, but in a forward direction. This is to "center the wheel"
  * while in the middle of a turn.
  */
-void Motor::SteerCenter(void)
+template <class Driver>
+void Motor<Driver>::SteerCenter(void)
 {
 	if (_leftSpeed > _rightSpeed) _rightSpeed = _leftSpeed;
 	else _leftSpeed = _rightSpeed;
 	MoveRelative();
 }
 
-bool Motor::IsMoving(void)
+template <class Driver>
+bool Motor<Driver>::IsMoving(void)
 {
 	return _isMoving;
 }
 
+template <class Driver>
+unsigned int Motor<Driver>::GetLeftSpeed(void)
+{
+	return _leftSpeed;
+}
+
+template <class Driver>
+unsigned int Motor<Driver>::GetRightSpeed(void)
+{
+	return _rightSpeed;
+}
+
+template <class Driver>
+unsigned int Motor<Driver>::GetLeftActualSpeed(void)
+{
+	return _leftActualSpeed;
+}
+
+template <class Driver>
+unsigned int Motor<Driver>::GetRightActualSpeed(void)
+{
+	return _rightActualSpeed;
+}
+
+template <class Driver>
+unsigned long Motor<Driver>::GetCommittedWrites(void)
+{
+	return _writesCommitted;
+}
+
+template <class Driver>
+unsigned long Motor<Driver>::GetSkippedWrites(void)
+{
+	return _writesSkipped;
+}
+
+template <class Driver>
+Driver& Motor<Driver>::GetDriver(void)
+{
+	return _driver;
+}
+
 ///////////////////////////////////////////////// Protected methods:
 
-void Motor::MoveForward(void)
+template <class Driver>
+void Motor<Driver>::MoveForward(void)
 {
 //#ifdef DEBUG
 //	Serial.println("MoveForward()");
 //#endif
-	_leftSpeed = min(forward, _leftSpeed + _delta);
-	_rightSpeed = min(forward, _rightSpeed + _delta);
+	_leftSpeed = min(Driver::forward, _leftSpeed + _delta);
+	_rightSpeed = min(Driver::forward, _rightSpeed + _delta);
 	MoveRelative();
 }
 
-void Motor::MoveReverse(void)
+template <class Driver>
+void Motor<Driver>::MoveReverse(void)
 {
 //#ifdef DEBUG
 //	Serial.println("MoveReverse()");
@@ -301,11 +366,11 @@ void Motor::MoveReverse(void)
 	if (_delta > _leftSpeed)
 		_leftSpeed = 0;
 	else
-		_leftSpeed = max(minimum, _leftSpeed - _delta);
+		_leftSpeed = max(Driver::minimum, _leftSpeed - _delta);
 	if (_delta > _rightSpeed)
 		_rightSpeed = 0;
 	else
-		_rightSpeed = max(minimum, _rightSpeed - _delta);
+		_rightSpeed = max(Driver::minimum, _rightSpeed - _delta);
 
 	MoveRelative();
 }
@@ -313,33 +378,42 @@ void Motor::MoveReverse(void)
 /*
  * This method is the one that actually sends the commands to the motors.
  * It is protected, and you shouldn't need to call it, unless you create a subclass.
+ *
+ * Only what changed since the last call is sent. E.g. a StopMovement() from the
+ * timeout while already stopped doesn't touch the hardware at all.
  */
-void Motor::Move(void)
+template <class Driver>
+void Motor<Driver>::Move(void)
 {
 //	#ifdef DEBUG
 //		Serial.print("Move() ");
 //	#endif
 
-	#ifdef USE_SERVOS
-		_leftTrackServo->writeMicroseconds(_leftActualSpeed);
-		_rightTrackServo->writeMicroseconds(_rightActualSpeed);
-	#endif
-
-	#ifdef USE_DC_MOTORS
-		_leftMotor->setSpeed(_leftActualSpeed);
-		if (_leftSpeed < neutral)
-			_leftMotor->run(BACKWARD); // Note that BACKWARD & FORWARD are defined in AFMotor.h
-		else
-			_leftMotor->run(FORWARD);
-
-		_rightMotor->setSpeed(_rightActualSpeed);
-		if (_rightSpeed < neutral)
-			_rightMotor->run(BACKWARD);
-		else
-			_rightMotor->run(FORWARD);
-	#endif
-
-	if (_leftSpeed == neutral && _rightSpeed == neutral)
+	bool leftReverse = _leftSpeed < Driver::neutral;
+	bool rightReverse = _rightSpeed < Driver::neutral;
+
+	uint8_t changes = _forceWrite ? writeAll : 0;
+	if (_leftActualSpeed != _committedLeftSpeed) changes |= writeLeftSpeed;
+	if (leftReverse != _committedLeftReverse) changes |= writeLeftDirection;
+	if (_rightActualSpeed != _committedRightSpeed) changes |= writeRightSpeed;
+	if (rightReverse != _committedRightReverse) changes |= writeRightDirection;
+
+	if (changes & writeLeft) _writesCommitted++;
+	else _writesSkipped++;
+	if (changes & writeRight) _writesCommitted++;
+	else _writesSkipped++;
+
+	if (changes != 0)
+	{
+		_driver.Write(changes, _leftActualSpeed, leftReverse, _rightActualSpeed, rightReverse);
+		_committedLeftSpeed = _leftActualSpeed;
+		_committedRightSpeed = _rightActualSpeed;
+		_committedLeftReverse = leftReverse;
+		_committedRightReverse = rightReverse;
+		_forceWrite = false;
+	}
+
+	if (_leftSpeed == Driver::neutral && _rightSpeed == Driver::neutral)
 		_isMoving = false;
 	else
 		_isMoving = true;
@@ -347,8 +421,11 @@ void Motor::Move(void)
 	lastMoveTime = millis();
 
 	// TODO: Update state with optional current heading (using compass &/or GPS module(s)).
-//	State* currentState = new SARC::State((unsigned int)0, (unsigned long)0, (unsigned int)_leftActualSpeed, (unsigned int)_rightActualSpeed);
-//	stateHistory->AddState(*currentState);
+	// The logical speeds are recorded (not the actual ones), because for DC motors
+	// the direction is only part of the logical speed.
+	#ifdef USE_BACKTRACK
+		stateHistory.AddState(SARC::State(0, 0, _leftSpeed, _rightSpeed));
+	#endif
 
 	#ifdef USE_LCD
 //		display->PrintLine("Left Track = "); display->Print(String(_leftActualSpeed, DEC));
@@ -357,4 +434,7 @@ void Motor::Move(void)
 	#endif // USE_LCD
 };
 
+// The driver is chosen at compile time (see MotorDrivers.h).
+template class Motor<RobotDriver>;
+
 } /* namespace SARC */
@@ -13,13 +13,20 @@
 namespace SARC {
 
 /*
+ * Drives both tracks through a Driver (see MotorDrivers.h). The Driver is a
+ * template parameter, not a base class, so its speed range is known at
+ * compile time and the calls to it are inlined.
  *
+ * The member functions are defined in Motor.cpp, which instantiates Motor for
+ * RobotDriver, the driver the build is configured for. Use RobotMotor.
  */
+template <class Driver>
 class Motor {
 public:
 	Motor(unsigned int, unsigned int);
 	void MoveRelative(void);
 	void SetSpeeds(unsigned int, unsigned int);
+	void MoveAbsolute(unsigned int, unsigned int);
 	void ValidateSpeeds(void);
 	void Turn(unsigned int, unsigned int);
 	void TurnLeftFullSpeed(void);
@@ -35,6 +42,21 @@ public:
 	void SteerCenter(void);
 	bool IsMoving(void);
 
+	// Logical speeds (see MotorDefs.h), and what they were converted to for
+	// the driver.
+	unsigned int GetLeftSpeed(void);
+	unsigned int GetRightSpeed(void);
+	unsigned int GetLeftActualSpeed(void);
+	unsigned int GetRightActualSpeed(void);
+
+	// Counted per track. A write is skipped when neither the speed nor the
+	// direction of the track changed.
+	unsigned long GetCommittedWrites(void);
+	unsigned long GetSkippedWrites(void);
+
+	// The driver, so a host build can see what it was told (see MockMotorDriver).
+	Driver& GetDriver(void);
+
 protected:
 	void Move(void);
 	void MoveForward(void);
@@ -48,17 +70,21 @@ private:
 	unsigned int _leftSpeed;
 	unsigned int _rightSpeed;
 
-	#ifdef USE_SERVOS
-		Servo *_leftTrackServo;
-		Servo *_rightTrackServo;
-	#endif // USE_SERVOS
-
-	#ifdef USE_DC_MOTORS
-		AF_DCMotor* _leftMotor;
-		AF_DCMotor* _rightMotor;
-	#endif // USE_DC_MOTORS
+	// What the hardware was last set to, so unchanged tracks aren't written.
+	unsigned int _committedLeftSpeed;
+	unsigned int _committedRightSpeed;
+	bool _committedLeftReverse;
+	bool _committedRightReverse;
+	bool _forceWrite;			// Nothing committed yet; the cache above is meaningless.
+	unsigned long _writesCommitted;
+	unsigned long _writesSkipped;
 
+	// A member, not a pointer, so it lives wherever the Motor does (see
+	// StaticObject.h) and nothing is allocated on the heap.
+	Driver _driver;
 };
 
+typedef Motor<RobotDriver> RobotMotor;
+
 } /* namespace SARC */
 #endif /* MOTOR_H_ */
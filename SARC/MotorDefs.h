@@ -19,6 +19,9 @@
 //#define USE_SERVOS
 //#define USE_VEX_MOTORS
 
+// Or, to build without any motor hardware (e.g. on a host), define this:
+//#define USE_MOCK_MOTORS
+
 #ifdef USE_SERVOS
 #include <Servo.h>
 
@@ -37,33 +40,6 @@
 
 #define SPEED_DELTA VEX_SPEED_DELTA
 
-namespace MotorDefs {
-/*
- * MotorDefs specify how movement is accomplished. Since we're always interested
- * in a direction for movement, we have this enumeration for natural language
- * concepts, e.g. forward, reverse, neutral and brake.
- *
- * Some *important* assumption are:
- * 		neutral - (forward - neutral) = reverse
- * 		neutral + (neutral - reverse) = forward
- * 	These "laws of speed delta" are used in the algorithms to reverse a course
- * 	stored in the command history.
- *
- * 	If your motor requirements do not meet this requirement, you should
- * 	modify reverse() accordingly.
- */
-	enum _MotorDefs
-	{
-		brake = VEX_BRAKE,
-		neutral = VEX_NEUTRAL,
-		forward = VEX_FULL_FORWARD,
-		reverse = VEX_FULL_REVERSE,
-		minimum = VEX_FULL_REVERSE,
-		relative = 0
-	} ;
-
-} // namespace MotorDefs
-
 #endif // USE_VEX_MOTORS
 
 #endif // USE_SERVOS
@@ -72,6 +48,7 @@ namespace MotorDefs {
 #ifdef USE_AF_MOTORS
 
 #include <AFMotor.h>
+#include <avr/pgmspace.h>
 /*
  * For Adafruit motor shield, I'm only supporting DC motors at this point.
  * (I will be happy to add support for others if you email me.)
@@ -107,21 +84,25 @@ namespace MotorDefs {
  */
 #define AF_MOTOR_SPEED		MOTOR12_1KHZ
 
-namespace MotorDefs {
-
-enum _MotorDefs
-	{
-		brake = 20,
-		neutral = 256,	// A bit kludgey for now, but allows unsigned ints. Actual value will be -255
-		forward = 511,	// so we can keep reverse relative for comparisons.
-		reverse = 255, 	// Note that for AFMotor, direction must be handled in Motor.cpp
-		//speed = 10,
-		minimum = 0,	// The actual minimum value
-		maximum = 255,	// The actual maximum value
-		relative = 255
-	} ;
-
-} // namespace MotorDefs
+/*
+ * Trim, so the tracks can be calibrated to run at the same speed. The duty
+ * cycle sent to each motor is (duty * GAIN / 100) + OFFSET, limited to 255.
+ * GAIN (percent) slows down the faster track; OFFSET is added to any duty but
+ * 0, to get a motor with a large dead band moving. These are applied through
+ * a table in flash (see MotorDrivers.cpp), so they cost nothing at run time.
+ */
+#ifndef AF_TRIM_LEFT_GAIN
+#define AF_TRIM_LEFT_GAIN		100
+#endif
+#ifndef AF_TRIM_LEFT_OFFSET
+#define AF_TRIM_LEFT_OFFSET		0
+#endif
+#ifndef AF_TRIM_RIGHT_GAIN
+#define AF_TRIM_RIGHT_GAIN		100
+#endif
+#ifndef AF_TRIM_RIGHT_OFFSET
+#define AF_TRIM_RIGHT_OFFSET	0
+#endif
 
 #define SPEED_CEILING 256
 
@@ -129,6 +110,42 @@ enum _MotorDefs
 
 #endif // USE_DC_MOTORS
 
+#if defined(USE_MOCK_MOTORS) && !defined(DELTA)
+#define DELTA 50
+#endif // USE_MOCK_MOTORS
+
+// The driver classes hold the speed range of each kind of motor.
+#include "MotorDrivers.h"
+
+namespace MotorDefs {
+/*
+ * MotorDefs specify how movement is accomplished. Since we're always interested
+ * in a direction for movement, we have this enumeration for natural language
+ * concepts, e.g. forward, reverse, neutral and brake. The values are those of
+ * the driver this build uses (see MotorDrivers.h).
+ *
+ * Some *important* assumption are:
+ * 		neutral - (forward - neutral) = reverse
+ * 		neutral + (neutral - reverse) = forward
+ * 	These "laws of speed delta" are used in the algorithms to reverse a course
+ * 	stored in the command history.
+ *
+ * 	If your motor requirements do not meet this requirement, you should
+ * 	modify reverse() accordingly.
+ */
+	enum _MotorDefs
+	{
+		brake = SARC::RobotDriver::brake,
+		neutral = SARC::RobotDriver::neutral,
+		forward = SARC::RobotDriver::forward,
+		reverse = SARC::RobotDriver::reverse,
+		minimum = SARC::RobotDriver::minimum,
+		maximum = SARC::RobotDriver::maximum,
+		relative = SARC::RobotDriver::relative
+	} ;
+
+} // namespace MotorDefs
+
 // General definitions to aid working with motor movements and deltas.
 // You may need to change, depending on how your motor "speeds" are defined.
 #define HALF_SPEED_DELTA ((forward - neutral) / 2)
@@ -0,0 +1,80 @@
+/*
+ * MotorDrivers.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Flash tables for the motor drivers. See MotorDrivers.h.
+ */
+
+#include "MotorDefs.h"
+
+#if defined(USE_DC_MOTORS) && defined(USE_AF_MOTORS)
+
+namespace SARC {
+
+/*
+ * The trim tables are generated by the preprocessor, one entry per duty
+ * cycle, so changing a trim in MotorDefs.h is all it takes to recalibrate.
+ */
+#define AF_TRIM_VALUE(duty, gain, offset)	((duty) * (gain) / 100 + (offset))
+#define AF_TRIM(duty, gain, offset) \
+	((duty) == 0 ? 0 : AF_TRIM_VALUE(duty, gain, offset) > 255 ? 255 : AF_TRIM_VALUE(duty, gain, offset))
+#define AF_TRIM_4(duty, gain, offset) \
+	AF_TRIM(duty, gain, offset), AF_TRIM((duty) + 1, gain, offset), \
+	AF_TRIM((duty) + 2, gain, offset), AF_TRIM((duty) + 3, gain, offset)
+#define AF_TRIM_16(duty, gain, offset) \
+	AF_TRIM_4(duty, gain, offset), AF_TRIM_4((duty) + 4, gain, offset), \
+	AF_TRIM_4((duty) + 8, gain, offset), AF_TRIM_4((duty) + 12, gain, offset)
+#define AF_TRIM_64(duty, gain, offset) \
+	AF_TRIM_16(duty, gain, offset), AF_TRIM_16((duty) + 16, gain, offset), \
+	AF_TRIM_16((duty) + 32, gain, offset), AF_TRIM_16((duty) + 48, gain, offset)
+#define AF_TRIM_TABLE(gain, offset) \
+	AF_TRIM_64(0, gain, offset), AF_TRIM_64(64, gain, offset), \
+	AF_TRIM_64(128, gain, offset), AF_TRIM_64(192, gain, offset)
+
+const uint8_t afLeftTrim[256] PROGMEM = { AF_TRIM_TABLE(AF_TRIM_LEFT_GAIN, AF_TRIM_LEFT_OFFSET) };
+const uint8_t afRightTrim[256] PROGMEM = { AF_TRIM_TABLE(AF_TRIM_RIGHT_GAIN, AF_TRIM_RIGHT_OFFSET) };
+
+/*
+ * The latch bit that drives motor (1 - 4) in the given direction. The bit
+ * positions are defined in AFMotor.h.
+ */
+uint8_t AFMotorDriver::LatchBit(uint8_t motor, bool reverse)
+{
+	switch (motor)
+	{
+		case 1:
+			return 1 << (reverse ? MOTOR1_B : MOTOR1_A);
+		case 2:
+			return 1 << (reverse ? MOTOR2_B : MOTOR2_A);
+		case 3:
+			return 1 << (reverse ? MOTOR3_B : MOTOR3_A);
+		case 4:
+			return 1 << (reverse ? MOTOR4_B : MOTOR4_A);
+		default:
+			return 0;
+	}
+}
+
+/*
+ * Shifts latch out to the 74HC595, the same way AFMotorController::latch_tx()
+ * does. The outputs only change on the rising edge of MOTORLATCH, so every
+ * motor changes direction at that one instant. Motors not driven by this
+ * driver are released.
+ */
+void AFMotorDriver::LatchDirections(uint8_t latch)
+{
+	digitalWrite(MOTORLATCH, LOW);
+	digitalWrite(MOTORDATA, LOW);
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		digitalWrite(MOTORCLK, LOW);
+		digitalWrite(MOTORDATA, (latch & (1 << (7 - i))) ? HIGH : LOW);
+		digitalWrite(MOTORCLK, HIGH);
+	}
+	digitalWrite(MOTORLATCH, HIGH);
+}
+
+} /* namespace SARC */
+
+#endif // USE_DC_MOTORS && USE_AF_MOTORS
@@ -0,0 +1,266 @@
+/*
+ * MotorDrivers.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Driver policies for Motor<Driver> (see Motor.h). A driver owns the
+ *  hardware of both tracks and defines the speed range of its motors, so
+ *  Motor's clamping and mapping are done with compile-time constants, and
+ *  the write path is inlined - there are no virtual calls.
+ *
+ *  Every driver provides:
+ *  	brake, neutral, forward, reverse, minimum, maximum, relative
+ *  		Speed constants, with the same meaning as in MotorDefs.h.
+ *  	Driver(unsigned int leftPin, unsigned int rightPin)
+ *  	static unsigned int ToActual(unsigned int speed)
+ *  		Converts a logical speed (reverse - relative ... forward) to the
+ *  		value that Write() takes.
+ *  	void Write(uint8_t changes, unsigned int leftActual, bool leftReverse,
+ *  	           unsigned int rightActual, bool rightReverse)
+ *  		Sends the parts flagged in changes (see MotorWrite) to the motors.
+ *  		Motor only flags what differs from the last Write(), so a driver
+ *  		never has to check for that itself. Both tracks should change at
+ *  		the same instant, or the robot swerves at every change of speed.
+ *
+ *  Only the drivers for the configured hardware are defined, because the
+ *  others' libraries aren't available. RobotDriver is the one this build
+ *  uses. Don't include this file directly; include MotorDefs.h.
+ */
+
+#ifndef MOTORDRIVERS_H_
+#define MOTORDRIVERS_H_
+
+#include <stdint.h>
+#include <Arduino.h>
+
+namespace SARC {
+
+// Flags for the changes argument of Driver::Write().
+enum MotorWrite
+{
+	writeLeftSpeed = 0x01,
+	writeLeftDirection = 0x02,
+	writeRightSpeed = 0x04,
+	writeRightDirection = 0x08,
+	writeLeft = writeLeftSpeed | writeLeftDirection,
+	writeRight = writeRightSpeed | writeRightDirection,
+	writeAll = writeLeft | writeRight
+};
+
+#if defined(USE_SERVOS) && defined(USE_VEX_MOTORS)
+/*
+ * VEX motors are driven like servos: the pulse width is the speed, with
+ * VEX_NEUTRAL in the middle. Logical and actual speeds are the same.
+ */
+class VexServoDriver
+{
+public:
+	enum
+	{
+		brake = VEX_BRAKE,
+		neutral = VEX_NEUTRAL,
+		forward = VEX_FULL_FORWARD,
+		reverse = VEX_FULL_REVERSE,
+		minimum = VEX_FULL_REVERSE,
+		maximum = VEX_FULL_FORWARD,
+		relative = 0
+	};
+
+	VexServoDriver(unsigned int leftPin, unsigned int rightPin)
+	{
+		_left.attach((int) leftPin);
+		_right.attach((int) rightPin);
+	}
+
+	static unsigned int ToActual(unsigned int speed) { return speed; }
+
+	// The direction is part of the pulse width. Both widths are set with
+	// interrupts off, so the servo interrupt never sends a pulse for one track
+	// while the other still has its old width. (The two can still be a frame
+	// apart if this lands between the left and right pulses of a frame. The
+	// Servo library doesn't expose its frame timing.)
+	void Write(uint8_t changes, unsigned int leftActual, bool, unsigned int rightActual, bool)
+	{
+		noInterrupts();
+		if (changes & writeLeftSpeed) _left.writeMicroseconds(leftActual);
+		if (changes & writeRightSpeed) _right.writeMicroseconds(rightActual);
+		interrupts();
+	}
+
+private:
+	Servo _left;
+	Servo _right;
+};
+#endif // USE_SERVOS && USE_VEX_MOTORS
+
+#if defined(USE_DC_MOTORS) && defined(USE_AF_MOTORS)
+// Trim tables, indexed by duty cycle. In flash; read with pgm_read_byte().
+extern const uint8_t afLeftTrim[256] PROGMEM;
+extern const uint8_t afRightTrim[256] PROGMEM;
+
+/*
+ * Adafruit motor shield DC motors take a speed of 0 - 255 and a separate
+ * direction. Logical speeds put reverse below neutral (see MotorDefs.h), so
+ * ToActual() folds them back onto 0 - 255. Each direction spans exactly the
+ * duty cycle range, so that is a subtraction, not a map().
+ *
+ * Write() passes each duty cycle through its motor's trim table.
+ *
+ * The direction of every motor on the shield is held in one 74HC595 latch.
+ * AF_DCMotor::run() shifts the whole latch out (about 100us) for each motor,
+ * so with run() the tracks would change direction 100us apart. Instead, this
+ * driver shifts out the directions of both tracks at once, in LatchDirections(),
+ * and then sets both duty cycles back to back with interrupts off. That means
+ * this driver owns the latch: don't call run() on these motors anywhere else.
+ */
+class AFMotorDriver
+{
+public:
+	enum
+	{
+		brake = 20,
+		neutral = 256,	// A bit kludgey for now, but allows unsigned ints. Actual value will be -255
+		forward = 511,	// so we can keep reverse relative for comparisons.
+		reverse = 255,
+		minimum = 0,	// The actual minimum value
+		maximum = 255,	// The actual maximum value
+		relative = 255
+	};
+
+	// The "pins" are the motor numbers on the shield, 1 - 4.
+	AFMotorDriver(unsigned int leftPin, unsigned int rightPin)
+		: _left((uint8_t) leftPin, AF_MOTOR_SPEED), _right((uint8_t) rightPin, AF_MOTOR_SPEED)
+	{
+		_leftForward = LatchBit((uint8_t) leftPin, false);
+		_leftReverse = LatchBit((uint8_t) leftPin, true);
+		_rightForward = LatchBit((uint8_t) rightPin, false);
+		_rightReverse = LatchBit((uint8_t) rightPin, true);
+	}
+
+	static unsigned int ToActual(unsigned int speed)
+	{
+		if (speed <= reverse)
+			return reverse - speed + minimum;
+		return speed - (forward - relative) + minimum;
+	}
+
+	void Write(uint8_t changes, unsigned int leftActual, bool leftReverse, unsigned int rightActual, bool rightReverse)
+	{
+		// Both directions in one latch transfer, even if only one changed.
+		if (changes & (writeLeftDirection | writeRightDirection))
+		{
+			LatchDirections((leftReverse ? _leftReverse : _leftForward)
+							| (rightReverse ? _rightReverse : _rightForward));
+		}
+
+		if (changes & (writeLeftSpeed | writeRightSpeed))
+		{
+			uint8_t left = pgm_read_byte(&afLeftTrim[(uint8_t) leftActual]);
+			uint8_t right = pgm_read_byte(&afRightTrim[(uint8_t) rightActual]);
+			noInterrupts();
+			if (changes & writeLeftSpeed) _left.setSpeed(left);
+			if (changes & writeRightSpeed) _right.setSpeed(right);
+			interrupts();
+		}
+	}
+
+private:
+	static uint8_t LatchBit(uint8_t motor, bool reverse);
+	static void LatchDirections(uint8_t latch);
+
+	// Fails to compile if ToActual() can't be a plain subtraction.
+	typedef char RelativeIsDutyRange[(relative == maximum - minimum) ? 1 : -1];
+
+	AF_DCMotor _left;
+	AF_DCMotor _right;
+	uint8_t _leftForward;		// Latch bits for each direction of each track
+	uint8_t _leftReverse;
+	uint8_t _rightForward;
+	uint8_t _rightReverse;
+};
+#endif // USE_DC_MOTORS && USE_AF_MOTORS
+
+#ifdef USE_MOCK_MOTORS
+/*
+ * No hardware at all. Remembers what was written, so Motor can be tested and
+ * benchmarked on a host. Uses the VEX range.
+ *
+ * Each track is stamped with micros() when it is set, whichever Write() call
+ * sets it, so the skew between the tracks can be measured across whole Motor
+ * updates (see host/tests/TestMotor.cpp), not just within one Write(). Get at
+ * the driver with Motor::GetDriver().
+ */
+class MockMotorDriver
+{
+public:
+	enum
+	{
+		brake = 200,
+		neutral = 1500,
+		forward = 2000,
+		reverse = 1000,
+		minimum = 1000,
+		maximum = 2000,
+		relative = 0
+	};
+
+	MockMotorDriver(unsigned int left, unsigned int right)
+	{
+		leftPin = left;
+		rightPin = right;
+		leftActual = neutral;
+		rightActual = neutral;
+		leftReverse = false;
+		rightReverse = false;
+		lastChanges = 0;
+		writes = 0;
+		leftTime = 0;
+		rightTime = 0;
+	}
+
+	static unsigned int ToActual(unsigned int speed) { return speed; }
+
+	void Write(uint8_t changes, unsigned int left, bool leftRev, unsigned int right, bool rightRev)
+	{
+		if (changes & writeLeft)
+		{
+			if (changes & writeLeftSpeed) leftActual = left;
+			if (changes & writeLeftDirection) leftReverse = leftRev;
+			leftTime = micros();
+		}
+		if (changes & writeRight)
+		{
+			if (changes & writeRightSpeed) rightActual = right;
+			if (changes & writeRightDirection) rightReverse = rightRev;
+			rightTime = micros();
+		}
+		lastChanges = changes;
+		writes++;
+	}
+
+	// Public, so tests can look at them.
+	unsigned int leftPin;
+	unsigned int rightPin;
+	unsigned int leftActual;
+	unsigned int rightActual;
+	bool leftReverse;
+	bool rightReverse;
+	uint8_t lastChanges;
+	unsigned long writes;
+	uint32_t leftTime;			// micros() when each track was last set
+	uint32_t rightTime;
+};
+#endif // USE_MOCK_MOTORS
+
+#if defined(USE_MOCK_MOTORS)
+	typedef MockMotorDriver RobotDriver;
+#elif defined(USE_SERVOS) && defined(USE_VEX_MOTORS)
+	typedef VexServoDriver RobotDriver;
+#elif defined(USE_DC_MOTORS) && defined(USE_AF_MOTORS)
+	typedef AFMotorDriver RobotDriver;
+#else
+	#error "No motor driver configured. See MotorDefs.h."
+#endif
+
+} /* namespace SARC */
+#endif /* MOTORDRIVERS_H_ */
@@ -0,0 +1,185 @@
+/*
+ * Protocol.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  See Protocol.h for the frame layout.
+ */
+
+#include "Protocol.h"
+
+namespace SARC {
+
+CommandParser::CommandParser()
+{
+	_mode = modeLegacy;
+	_nextMode = modeLegacy;
+	_state = waitingForStart;
+	_length = 0;
+	_received = 0;
+	_checksum = 0;
+	_position = 0;
+}
+
+/*
+ * In legacy mode every byte completes a "frame" of one command. In binary
+ * mode bytes are collected until a whole frame has arrived and checked.
+ * Garbage between frames is skipped, which also resynchronizes the parser
+ * after a corrupted length byte.
+ */
+ParseResult CommandParser::Feed(uint8_t c)
+{
+	if (_mode == modeLegacy)
+	{
+		if (c == PROTOCOL_MODE_BINARY)
+		{
+			_mode = modeBinary;
+			_nextMode = modeBinary;
+			_state = waitingForStart;
+		}
+		else if (ArgumentLength((char)c) != 0)
+		{
+			// A single character can't carry the arguments.
+			_position = _length;
+			return parseBadCommand;
+		}
+		_payload[0] = c;
+		_length = 1;
+		_position = 0;
+		return parseReady;
+	}
+
+	switch (_state)
+	{
+		case waitingForStart:
+			if (c == PROTOCOL_FRAME_START)
+				_state = waitingForLength;
+			break;
+
+		case waitingForLength:
+			if (c == 0 || c > PROTOCOL_MAX_PAYLOAD)
+			{
+				_state = waitingForStart;
+				return parseBadLength;
+			}
+			_length = c;
+			_received = 0;
+			_position = _length;	// Nothing to hand out until the frame is complete.
+			_checksum = c;
+			_state = readingPayload;
+			break;
+
+		case readingPayload:
+			_payload[_received++] = c;
+			_checksum ^= c;
+			if (_received == _length)
+				_state = waitingForChecksum;
+			break;
+
+		case waitingForChecksum:
+			_state = waitingForStart;
+			if (c != _checksum)
+				return parseBadChecksum;
+			return Validate();
+	}
+
+	return parseIncomplete;
+}
+
+/*
+ * Walks the payload once without executing anything, so a frame with a
+ * truncated argument list is rejected as a whole.
+ */
+ParseResult CommandParser::Validate(void)
+{
+	uint8_t i = 0;
+	while (i < _length)
+	{
+		i += 1 + ArgumentLength((char)_payload[i]);
+	}
+	if (i != _length)
+	{
+		_position = _length;
+		return parseBadCommand;
+	}
+	_position = 0;
+	return parseReady;
+}
+
+bool CommandParser::NextCommand(Command& command)
+{
+	if (_position >= _length) return false;
+
+	command.opcode = (char)_payload[_position++];
+	command.arg1 = 0;
+	command.arg2 = 0;
+
+	if (_mode == modeBinary)
+	{
+		uint8_t argLength = ArgumentLength(command.opcode);
+		if (argLength >= 2)
+		{
+			command.arg1 = _payload[_position] | ((unsigned int)_payload[_position + 1] << 8);
+		}
+		if (argLength >= 4)
+		{
+			command.arg2 = _payload[_position + 2] | ((unsigned int)_payload[_position + 3] << 8);
+		}
+		_position += argLength;
+
+		// Takes effect for the bytes after this frame. The rest of the frame
+		// still holds binary commands and their arguments.
+		if (command.opcode == CMODE_LEGACY)
+			_nextMode = modeLegacy;
+		if (_position >= _length)
+			_mode = _nextMode;
+	}
+	return true;
+}
+
+ProtocolMode CommandParser::GetMode(void)
+{
+	return _mode;
+}
+
+void CommandParser::Resynchronize(void)
+{
+	_state = waitingForStart;
+}
+
+uint8_t CommandParser::ArgumentLength(char opcode)
+{
+	switch (opcode)
+	{
+		case CSET_SPEEDS:
+			return 4;
+		case CSET_DELTA:
+		case CTELEMETRY:
+			return 2;
+		default:
+			return 0;
+	}
+}
+
+uint8_t* PutInt(uint8_t* buffer, unsigned int value)
+{
+	buffer[0] = (uint8_t)value;
+	buffer[1] = (uint8_t)(value >> 8);
+	return buffer + 2;
+}
+
+uint8_t* PutLong(uint8_t* buffer, unsigned long value)
+{
+	buffer[0] = (uint8_t)value;
+	buffer[1] = (uint8_t)(value >> 8);
+	buffer[2] = (uint8_t)(value >> 16);
+	buffer[3] = (uint8_t)(value >> 24);
+	return buffer + 4;
+}
+
+unsigned int Clamp16(unsigned long value)
+{
+	return value > 0xFFFFUL ? 0xFFFFU : (unsigned int)value;
+}
+
+} /* namespace SARC */
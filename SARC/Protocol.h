@@ -0,0 +1,165 @@
+/*
+ * Protocol.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Command protocol for SARC. Two modes are supported:
+ *
+ *  Legacy mode (the default) - every received character is one command,
+ *  exactly as the original telnet interface worked. Old clients never
+ *  notice that anything else exists.
+ *
+ *  Binary mode - entered by sending the PROTOCOL_MODE_BINARY byte while in
+ *  legacy mode. Commands are then sent in frames:
+ *
+ *  	[FRAME_START] [LENGTH] [PAYLOAD ... ] [CHECKSUM]
+ *
+ *  FRAME_START is PROTOCOL_FRAME_START, LENGTH is the number of payload bytes
+ *  (1 - PROTOCOL_MAX_PAYLOAD) and CHECKSUM is the XOR of LENGTH and every
+ *  payload byte. The payload is a sequence of commands, each of which is an
+ *  opcode optionally followed by little-endian 16-bit arguments. The opcodes
+ *  are the legacy command characters, plus the argument-carrying opcodes
+ *  below that only make sense in binary mode. So a client can send e.g.
+ *  "set speeds to full forward, then steer center" in one frame of 8 bytes.
+ *
+ *  A frame is validated completely before any of its commands are handed
+ *  out, so a corrupted frame never partially executes.
+ *
+ *  The CommandParser only decodes. Executing the commands is left to the
+ *  caller (see ProcessCommand() in SARC.cpp).
+ */
+
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+#include <stdint.h>
+
+/************ ROBOT COMMAND DEFINITIONS ************/
+#define CMAINTAIN		'm'
+#define CBRAKE			'b'
+#define CSTOP           'q'
+#define CFORWARD        'w'
+#define CREVERSE        's'
+#define CLEFT           'a'
+#define CRIGHT          'd'
+#define CSTEER_CENTER	'c'
+#define CREPLY_VERBOSE	'v'		// Text reply for every command (default for legacy clients)
+#define CREPLY_COMPACT	'k'		// Status code replies (default for binary clients)
+#define CREPLY_SILENT	'n'		// Only errors are reported
+#define CFORWARD_FULL   'W'
+#define CREVERSE_FULL   'S'
+#define CLEFTFULL       'A'
+#define CRIGHTFULL      'D'
+#define CLOOP_STATS		'i'		// Loop timing report (see LoopStats.h)
+#define CLOOP_STATS_RESET	'I'		// Clears the loop and task timing statistics
+#define CTASK_STATS		'j'		// Per-task timing report (see Scheduler.h)
+#define CMEMORY_STATUS	'r'		// RAM report (see MemoryDiag.h), also shown on the LCD
+
+// Binary mode only. Arguments are unsigned 16-bit, little-endian.
+#define CSET_SPEEDS		'V'		// Absolute logical speeds: left, right (see MotorDefs.h)
+#define CSET_DELTA		'x'		// Acceleration step used by w/s/a/d: delta, at most forward - minimum
+#define CMODE_LEGACY	'L'		// Leave binary mode after this frame
+#define CTELEMETRY		't'		// Telemetry period in milliseconds, 0 = off (see Telemetry.h)
+
+/************ STATUS CODES ************/
+// Compact replies are [STATUS][OPCODE]. Status codes have the high bit set,
+// so they can't be confused with text. Anything but STATUS_OK is followed by
+// a text line describing the error.
+#define STATUS_OK				0x80
+#define STATUS_UNRECOGNIZED		0x81
+#define STATUS_BAD_LENGTH		0x82
+#define STATUS_BAD_CHECKSUM		0x83
+#define STATUS_BAD_COMMAND		0x84
+#define STATUS_NOT_CONTROLLER	0x85	// An observer sent a driving command (see Connection.h)
+
+// Queries (e.g. CLOOP_STATS) answer with a report in every reply mode:
+// [STATUS_OK][OPCODE][LENGTH][DATA ...], LENGTH bytes of binary data.
+#define REPORT_HEADER_SIZE		3
+
+/************ FRAMING ************/
+#define PROTOCOL_MODE_BINARY	0x02	// STX. Also reported as the opcode of the mode switch.
+#define PROTOCOL_FRAME_START	0xA5
+#define PROTOCOL_MAX_PAYLOAD	32
+
+namespace SARC {
+
+enum ProtocolMode
+{
+	modeLegacy = 0,
+	modeBinary = 1
+};
+
+enum ParseResult
+{
+	parseIncomplete = 0,	// Need more bytes.
+	parseReady,				// Commands are available from NextCommand().
+	parseBadLength,			// Frame length was zero or too large.
+	parseBadChecksum,		// Frame was discarded.
+	parseBadCommand			// Frame held truncated arguments.
+};
+
+enum ReplyMode
+{
+	replyVerbose = 0,
+	replyCompact,
+	replySilent
+};
+
+struct Command
+{
+	char opcode;
+	unsigned int arg1;
+	unsigned int arg2;
+};
+
+class CommandParser
+{
+public:
+	CommandParser();
+
+	// Feeds one received byte to the parser.
+	ParseResult Feed(uint8_t c);
+
+	// Returns the next decoded command of the current frame, or false when
+	// all of them have been handed out.
+	bool NextCommand(Command& command);
+
+	ProtocolMode GetMode(void);
+
+	// Drops a frame that is only partly received. The mode is kept.
+	void Resynchronize(void);
+
+	// Number of argument bytes that follow the opcode in binary mode.
+	static uint8_t ArgumentLength(char opcode);
+
+private:
+	enum ParserState
+	{
+		waitingForStart,
+		waitingForLength,
+		readingPayload,
+		waitingForChecksum
+	};
+
+	ParseResult Validate(void);
+
+	ProtocolMode _mode;
+	ProtocolMode _nextMode;	// Takes over once the current frame is used up.
+	uint8_t _state;
+	uint8_t _length;
+	uint8_t _received;
+	uint8_t _checksum;
+	uint8_t _position;
+	uint8_t _payload[PROTOCOL_MAX_PAYLOAD];
+};
+
+// Encoders for report data (see REPORT_HEADER_SIZE). Fields are little-endian.
+// @return: The byte after the field.
+uint8_t* PutInt(uint8_t* buffer, unsigned int value);
+uint8_t* PutLong(uint8_t* buffer, unsigned long value);
+
+// Saturates a count or time for a 16-bit field.
+unsigned int Clamp16(unsigned long value);
+
+} /* namespace SARC */
+#endif /* PROTOCOL_H_ */
@@ -0,0 +1,99 @@
+/*
+ * RingBuffer.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Fixed capacity circular buffer. The storage is part of the object, so
+ *  nothing is ever allocated on the heap, and adding an element is O(1):
+ *  once the buffer is full, PushBack() overwrites the oldest element.
+ *
+ *  Iteration is newest to oldest (like std::vector's reverse_iterator),
+ *  because that's the order needed for backtracking. Incrementing a
+ *  reverse_iterator moves to the previous (older) element.
+ *
+ *  T must be default constructible and assignable.
+ */
+
+#ifndef RINGBUFFER_H_
+#define RINGBUFFER_H_
+
+namespace SARC {
+
+template <typename T, unsigned int CAPACITY>
+class RingBuffer
+{
+public:
+
+	class reverse_iterator
+	{
+	public:
+		reverse_iterator() : _buffer(0), _offset(0) {}
+		reverse_iterator(RingBuffer* buffer, unsigned int offset) : _buffer(buffer), _offset(offset) {}
+
+		T& operator*() const { return _buffer->FromNewest(_offset); }
+		T* operator->() const { return &_buffer->FromNewest(_offset); }
+		reverse_iterator& operator++() { _offset++; return *this; }
+		reverse_iterator operator++(int) { reverse_iterator old = *this; _offset++; return old; }
+		bool operator==(const reverse_iterator& other) const { return _offset == other._offset && _buffer == other._buffer; }
+		bool operator!=(const reverse_iterator& other) const { return !(*this == other); }
+
+		// Number of elements newer than the current one.
+		unsigned int Offset(void) const { return _offset; }
+
+	private:
+		RingBuffer* _buffer;
+		unsigned int _offset;
+	};
+
+	RingBuffer() : _head(0), _count(0) {}
+
+	// Appends an element, overwriting the oldest one if the buffer is full.
+	void PushBack(const T& item)
+	{
+		_items[_head] = item;
+		_head = (_head + 1 < CAPACITY) ? _head + 1 : 0;
+		if (_count < CAPACITY) _count++;
+	}
+
+	// Removes the oldest element.
+	void PopFront(void)
+	{
+		if (_count > 0) _count--;
+	}
+
+	// Removes the count newest elements.
+	void PopBack(unsigned int count)
+	{
+		if (count > _count) count = _count;
+		_head = (_head >= count) ? _head - count : _head + CAPACITY - count;
+		_count -= count;
+	}
+
+	void Clear(void) { _head = 0; _count = 0; }
+
+	// offset 0 is the newest element, Size() - 1 the oldest.
+	T& FromNewest(unsigned int offset)
+	{
+		return _items[(_head > offset) ? _head - 1 - offset : _head + CAPACITY - 1 - offset];
+	}
+
+	T& Back(void) { return FromNewest(0); }
+	T& Front(void) { return FromNewest(_count - 1); }
+
+	unsigned int Size(void) const { return _count; }
+	unsigned int Capacity(void) const { return CAPACITY; }
+	bool Empty(void) const { return _count == 0; }
+	bool Full(void) const { return _count == CAPACITY; }
+
+	reverse_iterator rbegin(void) { return reverse_iterator(this, 0); }
+	reverse_iterator rend(void) { return reverse_iterator(this, _count); }
+
+private:
+	T _items[CAPACITY];
+	unsigned int _head;		// Where the next element goes.
+	unsigned int _count;
+};
+
+} // namespace SARC
+
+#endif /* RINGBUFFER_H_ */
@@ -28,6 +28,25 @@
  * q = Stop (immediate)
  * m = Maintain current speed
  *
+ * Newer clients can switch to a framed binary protocol that batches several
+ * commands, with absolute arguments, in one frame. See Protocol.h.
+ *
+ * Replies are text lines by default. Send 'k' for compact 2-byte status
+ * codes or 'n' for no replies on success, and 'v' to get the text back.
+ *
+ * 'i' reports how long each pass of loop() takes (see LoopStats.h), in
+ * binary, 'j' how long each task takes (see Scheduler.h), and 'I' clears
+ * both. 'r' reports free RAM and the stack and heap high-water marks (see
+ * MemoryDiag.h). Binary clients can also ask for a periodic telemetry stream
+ * (see Telemetry.h).
+ *
+ * Several clients can be connected at once. The first one drives; the others
+ * can watch and query, but not move the robot (see Connection.h). With
+ * USE_UDP, commands can also be sent as sequence-numbered UDP datagrams, where
+ * a late datagram is dropped rather than holding up newer ones. With
+ * USE_XBEE_API, the XBee runs in API mode: checksummed frames at a higher baud
+ * rate, and the client counts as gone when its radio stops acknowledging.
+ *
  * Note that the PULSE definitions are for Vex Robotics systems.
  * Also note that if this is on a robot, you need either WiFi or
  * a wireless router onboard so you can telnet to it. :)
@@ -41,65 +60,140 @@
 
 // Do not remove the include below
 #include "SARC.h"
-//#include "State.h"
 #include "ArduinoUtils.h"
 #include "MotorDefs.h"
 #include "Motor.h"
 #include "Display.h"
-#include "connection.h"
+#include "Connection.h"
+#include "Protocol.h"
+#include "Scheduler.h"
+#include "State.h"
+#include "Backtrack.h"
+#include "StaticObject.h"
+#include "LoopStats.h"
+#include "MemoryDiag.h"
+#include "Telemetry.h"
 #include <Arduino.h>
 
 //#define DEBUG
 
-/************ ROBOT COMMAND DEFINITIONS ************/
-#define CMAINTAIN		'm'
-#define CBRAKE			'b'
-#define CSTOP           'q'
-#define CFORWARD        'w'
-#define CREVERSE        's'
-#define CLEFT           'a'
-#define CRIGHT          'd'
-#define CSTEER_CENTER	'c'
-#define CFORWARD_FULL   'W'
-#define CREVERSE_FULL   'S'
-#define CLEFTFULL       'A'
-#define CRIGHTFULL      'D'
-
 /************ ROBOT MOVEMENT DEFINITIONS ************/
 // If motors are moving and this many milliseconds pass, stop motors.
 #define MOVEMENT_TIMEOUT 5000		// 5000 = 5 seconds
 
-// If client has been connected for this long (milliseconds), start backtracking to signal.
-//#define TIME_UNTIL_BACKTRACK 3000	// 30000 = 30 seconds
+// Largest acceleration step CSET_DELTA accepts: the whole range of a track.
+// Anything bigger could overflow a speed (an unsigned int) in Motor.
+#define MAX_DELTA ((unsigned int)(SARC::RobotDriver::forward - SARC::RobotDriver::minimum))
+
+// With USE_XBEE_API, the client counts as gone after this many packets in a
+// row that its radio didn't acknowledge, until something is received again.
+#define LINK_MAX_FAILURES		4
+
+// If the controlling client sends nothing for this long (milliseconds), it
+// counts as gone, just as if it had disconnected, until it sends something
+// again. That catches a dead link long before TCP gives up on it, but the
+// client has to keep sending (e.g. 'm') more often than this. 0 = off, for
+// clients that don't.
+#ifndef HEARTBEAT_TIMEOUT
+#define HEARTBEAT_TIMEOUT		0
+#endif
+
+/************ TASK DEFINITIONS ************/
+// Received bytes handled per scheduler pass. Keeps command intake bounded in time.
+#define INTAKE_BYTES_PER_PASS	8
+
+// How often queued LCD output is drained (microseconds). 0 = every pass; each
+// pass only sends what the LCD can take without blocking.
+#define DISPLAY_REFRESH_PERIOD	0UL
+
+// Expected worst case run time of each task (microseconds). Runs that take
+// longer are counted as overruns in the scheduler statistics.
+#define INTAKE_BUDGET			2000UL
+#define MOTOR_UPDATE_BUDGET		500UL
+#define TIMEOUT_BUDGET			500UL
+#define DISPLAY_BUDGET			500UL
+#define TELEMETRY_BUDGET		1000UL
+#define HEARTBEAT_BUDGET		500UL
+#define BACKTRACK_START_BUDGET	1000UL
+
+// Passes of loop() that take longer than this (microseconds) are counted in
+// the loop statistics.
+#define LOOP_BUDGET				4000UL
+
+/************ MEMORY DEFINITIONS ************/
+// The Motor, Connection and Display are constructed in setup(), into static
+// storage reserved below, so they never come from the heap. The build fails
+// if together they need more than this many bytes of RAM.
+#ifndef STATIC_OBJECT_BUDGET
+#define STATIC_OBJECT_BUDGET	384
+#endif
+
+// If client has been disconnected for this long (milliseconds), start backtracking to signal.
+// Only used if USE_BACKTRACK is defined.
+#define TIME_UNTIL_BACKTRACK 30000	// 30000 = 30 seconds
 
 // TODO: Refactor to get rid of all global variables (or at least global class pointers).
 /************ History ************/
-//SARC::StateHistory *stateHistory = NULL; // This is populated in Motor.cpp
-unsigned long lastMoveTime;
-//SARC::state_reverse_iterator backtrackIterator;
-//bool haveBacktrackIterator;
-//bool inAutoMove;				// We're replaying history/moving automatically!
-//unsigned long autoMoveExpires;	// The milliseconds that the current movement should be stopped.
-//unsigned long previousTicks;	// The milliseconds for the previous call of loop().
-bool displayedWaitingMessage = false;
-//unsigned long ticksLastConnected = 0L;
+uint32_t lastMoveTime;
+#ifdef USE_BACKTRACK
+	SARC::StateHistory stateHistory(MAX_HISTORY);	// This is populated in Motor.cpp
+	SARC::BacktrackEngine backtrack(stateHistory);
+#endif
+uint8_t backtrackTask = SCHEDULER_NO_TASK;		// Armed while the client is gone.
 
 /************ Motors ************/
-SARC::Motor* motor = NULL;
+SARC::StaticObject<SARC::RobotMotor> motorStorage;
+SARC::RobotMotor* motor = NULL;
 
 /************ Connection ************/
+SARC::StaticObject<SARC::Connection> connectionStorage;
 SARC::Connection* connection = NULL;
+// Protocol state of each client. Every client starts out as a legacy client.
+struct ClientSession
+{
+	SARC::CommandParser parser;
+	SARC::ReplyMode replyMode;
+	bool telemetry;			// Asked for the telemetry stream.
+
+	ClientSession() : replyMode(SARC::replyVerbose), telemetry(false) {}
+};
+ClientSession sessions[CONNECTION_MAX_SESSIONS];
+ClientSession* session = &sessions[0];		// The one whose input is being processed.
+bool clientConnected = false;				// A client is in control.
+uint8_t deliveryFailures = 0;				// Packets in a row that weren't delivered.
+uint8_t heartbeatTask = SCHEDULER_NO_TASK;
+bool heartbeatLost = false;					// The controller has gone quiet.
 
 /************ Display ************/
 #ifdef USE_LCD
+	SARC::StaticObject<Display> displayStorage;
 	Display *display = NULL;
+	#define DISPLAY_STORAGE_SIZE	sizeof(displayStorage)
+#else
+	#define DISPLAY_STORAGE_SIZE	0
 #endif
 
+STATIC_RAM_CHECK(sizeof(motorStorage) + sizeof(connectionStorage) + DISPLAY_STORAGE_SIZE <= STATIC_OBJECT_BUDGET,
+				 StaticObjectsFitBudget);
+
+/************ Scheduler ************/
+SARC::Scheduler scheduler(micros);
+uint8_t timeoutTask = SCHEDULER_NO_TASK;
+SARC::LoopStats loopStats(LOOP_BUDGET);
+
+/************ Telemetry ************/
+SARC::Telemetry telemetry;
+uint8_t telemetryTask = SCHEDULER_NO_TASK;
+uint32_t lastCommandTime = 0;
+
 /************ Misc. global variables ************/
 unsigned int delta = DELTA;
 
 void setup()
 {
+	// Before anything else uses the stack.
+	SARC::MemoryDiag::PaintStack();
+
 	#ifdef DEBUG
 		// Initialize serial communication for debug output.
 		Serial.begin(9600);
@@ -108,7 +202,7 @@ void setup()
 
 	#ifdef USE_LCD
 		// Initialize LCD.
-		display = new Display();
+		display = displayStorage.Construct();
 		delay(1000); // Pause to allow device to initialize.
 		display->Clear();
 		display->Home();
@@ -118,7 +212,7 @@ void setup()
 	#endif
 
 	// Initialize connection.
-	connection = new SARC::Connection();
+	connection = connectionStorage.Construct();
 	delay(1000); // Pause to allow device to initialize.
 	#ifdef DEBUG
 		Serial.println("Communication initialized.");
@@ -127,276 +221,631 @@ void setup()
 		display->PrintLine("Comm init'd.");
 	#endif
 
-	// Initialize state history.
-//	stateHistory = new SARC::StateHistory((unsigned int)MAX_HISTORY);
-//	#ifdef DEBUG
-//		Serial.println("History initialized.");
-//	#endif
-//	#ifdef USE_LCD
-//		display->PrintLine("History init'd.");
-//	#endif
-
-	#ifdef USE_SERVOS
+	#if defined(USE_MOCK_MOTORS)
+		// No motor hardware. (See MotorDrivers.h.)
+		motor = motorStorage.Construct(0U, 0U);
+	#elif defined(USE_SERVOS)
 		// Initialize VEX motors.
-		motor = new SARC::Motor(PIN_LEFT_SERVO, PIN_RIGHT_SERVO);
+		motor = motorStorage.Construct(PIN_LEFT_SERVO, PIN_RIGHT_SERVO);
 		#ifdef DEBUG
 			Serial.println("Servos initialized.");
 		#endif
 		#ifdef USE_LCD
 			display->PrintLine("Servos init'd.");
 		#endif
+	#elif defined(USE_DC_MOTORS) && defined(USE_AF_MOTORS)
+		// Initialize adafruit motors.
+		motor = motorStorage.Construct(AF_MOTOR_LEFT, AF_MOTOR_RIGHT);
 	#endif
 
-	#ifdef USE_DC_MOTORS
-	#ifdef USE_AF_MOTORS
-		// Initialize adafruit motors.
-		motor = new SARC::Motor(AF_MOTOR_LEFT, AF_MOTOR_RIGHT);
+	// Initialize tasks. They run in this order on every pass of loop().
+	scheduler.AddPeriodic("Intake", CommandIntakeTask, 0, INTAKE_BUDGET);
+	scheduler.AddPeriodic("Motors", MotorUpdateTask, 0, MOTOR_UPDATE_BUDGET);
+	timeoutTask = scheduler.AddDeadline("Timeout", MovementTimeoutTask, TIMEOUT_BUDGET);
+	scheduler.Arm(timeoutTask, MOVEMENT_TIMEOUT * 1000UL);
+	#ifdef USE_LCD
+		scheduler.AddPeriodic("Display", DisplayRefreshTask, DISPLAY_REFRESH_PERIOD, DISPLAY_BUDGET);
 	#endif
+	telemetryTask = scheduler.AddPeriodic("Telemetry", TelemetryTask, TELEMETRY_MIN_PERIOD, TELEMETRY_BUDGET);
+	scheduler.Disarm(telemetryTask);	// Until a client asks for it.
+	#if HEARTBEAT_TIMEOUT > 0
+		heartbeatTask = scheduler.AddDeadline("Heartbeat", HeartbeatTask, HEARTBEAT_BUDGET);
+	#endif
+	#ifdef USE_BACKTRACK
+		backtrackTask = scheduler.AddDeadline("Backtrack", BacktrackStartTask, BACKTRACK_START_BUDGET);
 	#endif
 
-	// Initialize backtrack control variables.
-//	haveBacktrackIterator = false;
-//	autoMoveExpires = 0;
-//	inAutoMove = false;
+	#ifdef DEBUG
+		Serial.println("Waiting for client.");
+	#endif
+	#ifdef USE_LCD
+		display->PrintLine("Waiting for client.");
+	#endif
 
 #ifdef DEBUG
 	Serial.println("Entering loop().");
 #endif
 }
 
-void loop()
+/*
+ * Reports success of a command to the client. The text is only sent in
+ * verbose mode. Compact mode sends STATUS_OK and the opcode (2 bytes) and
+ * silent mode sends nothing at all.
+ */
+void Acknowledge(char opcode, const char* text)
+{
+	if (session->replyMode == SARC::replyVerbose)
+	{
+		connection->PrintLine(text);
+	}
+	else if (session->replyMode == SARC::replyCompact)
+	{
+		uint8_t reply[2];
+		reply[0] = STATUS_OK;
+		reply[1] = (uint8_t)opcode;
+		connection->Write(reply, sizeof(reply));
+	}
+}
+
+/*
+ * Reports an error to the client. Errors always include the text. Outside of
+ * verbose mode, it is preceded by the status code and the opcode (0 if the
+ * error is about a whole frame) so binary clients stay in sync.
+ */
+void Reject(uint8_t status, char opcode, const char* text)
+{
+	if (session->replyMode != SARC::replyVerbose)
+	{
+		uint8_t reply[2];
+		reply[0] = status;
+		reply[1] = (uint8_t)opcode;
+		connection->Write(reply, sizeof(reply));
+	}
+	connection->PrintLine(text);
+}
+
+/*
+ * Answers a query. reply holds REPORT_HEADER_SIZE free bytes, then length
+ * bytes of data. Reports are sent in every reply mode, as the client asked
+ * for them. See Protocol.h. recipients has a bit (1 << session) for each
+ * client to send it to; 0 answers the current one.
+ */
+void Report(char opcode, uint8_t* reply, uint8_t length, uint8_t recipients)
+{
+	reply[0] = STATUS_OK;
+	reply[1] = (uint8_t)opcode;
+	reply[2] = length;
+	if (recipients != 0) connection->Broadcast(reply, REPORT_HEADER_SIZE + length, recipients);
+	else connection->Write(reply, REPORT_HEADER_SIZE + length);
+}
+
+/*
+ * Commands that move the robot (or change how it moves). Only the client in
+ * control may send these.
+ */
+bool IsDrivingCommand(char opcode)
+{
+	switch (opcode)
+	{
+		case CMAINTAIN:
+		case CBRAKE:
+		case CSTOP:
+		case CFORWARD:
+		case CREVERSE:
+		case CLEFT:
+		case CRIGHT:
+		case CSTEER_CENTER:
+		case CFORWARD_FULL:
+		case CREVERSE_FULL:
+		case CLEFTFULL:
+		case CRIGHTFULL:
+		case CSET_SPEEDS:
+		case CSET_DELTA:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+ * Executes one decoded command. Legacy single character commands and the
+ * commands of binary frames both end up here. See Protocol.h.
+ */
+void ProcessCommand(const SARC::Command& command)
+{
+	#ifdef DEBUG
+		Serial.print("Processing command: ");
+		Serial.println(command.opcode);
+	#endif
+
+	if (IsDrivingCommand(command.opcode) && !connection->IsController())
+	{
+		Reject(STATUS_NOT_CONTROLLER, command.opcode, "Not in control.");
+		return;
+	}
+
+	lastCommandTime = millis();
+
+	switch (command.opcode)
+	{
+		case CMAINTAIN:
+			lastMoveTime = millis();
+			Acknowledge(command.opcode, "Maintaining current speed.");
+			break;
+
+		case CSTOP:
+			Acknowledge(command.opcode, "Full Stop.");
+			motor->StopMovement();
+			ShowStatus("Full Stop.");
+			break;
+
+		case CFORWARD:
+			Acknowledge(command.opcode, "Accelerating.");
+			motor->AccelerateForward(delta);
+			ShowStatus("Accelerating.");
+			break;
+
+		case CREVERSE:
+			Acknowledge(command.opcode, "Decelerating.");
+			motor->AccelerateReverse(delta);
+			ShowStatus("Decelerating.");
+			break;
+
+		case CLEFT:
+			Acknowledge(command.opcode, "Turning left.");
+			motor->TurnLeft(delta);
+			ShowStatus("Turning left.");
+			break;
+
+		case CRIGHT:
+			Acknowledge(command.opcode, "Turning right.");
+			motor->TurnRight(delta);
+			ShowStatus("Turning right.");
+			break;
+
+		case CFORWARD_FULL:
+			Acknowledge(command.opcode, "Full forward.");
+			motor->MoveForwardFullSpeed();
+			ShowStatus("Full forward.");
+			break;
+
+		case CREVERSE_FULL:
+			Acknowledge(command.opcode, "Full reverse.");
+			motor->MoveReverseFullSpeed();
+			ShowStatus("Full reverse.");
+			break;
+
+		case CLEFTFULL:
+			Acknowledge(command.opcode, "Full left.");
+			motor->TurnLeftFullSpeed();
+			ShowStatus("Full left.");
+			break;
+
+		case CRIGHTFULL:
+			Acknowledge(command.opcode, "Full right.");
+			motor->TurnRightFullSpeed();
+			ShowStatus("Full right.");
+			break;
+
+		case CBRAKE:
+			Acknowledge(command.opcode, "Braking.");
+			motor->Brake();
+			ShowStatus("Braking.");
+			break;
+
+		case CSTEER_CENTER:
+			Acknowledge(command.opcode, "Centering.");
+			motor->SteerCenter();
+			ShowStatus("Centering.");
+			break;
+
+		case CSET_SPEEDS:
+			Acknowledge(command.opcode, "Setting speeds.");
+			motor->MoveAbsolute(command.arg1, command.arg2);
+			break;
+
+		case CSET_DELTA:
+			if (command.arg1 > MAX_DELTA)
+			{
+				Reject(STATUS_BAD_COMMAND, command.opcode, "Delta out of range.");
+				break;
+			}
+			delta = command.arg1;
+			Acknowledge(command.opcode, "Delta set.");
+			break;
+
+		case CLOOP_STATS:
+		{
+			uint8_t reply[REPORT_HEADER_SIZE + LOOP_STATS_DUMP_SIZE];
+			loopStats.Dump(reply + REPORT_HEADER_SIZE);
+			Report(command.opcode, reply, LOOP_STATS_DUMP_SIZE);
+			break;
+		}
+
+		case CTASK_STATS:
+		{
+			uint8_t reply[REPORT_HEADER_SIZE + SCHEDULER_DUMP_SIZE];
+			Report(command.opcode, reply, scheduler.Dump(reply + REPORT_HEADER_SIZE));
+			break;
+		}
+
+		case CMEMORY_STATUS:
+		{
+			uint8_t reply[REPORT_HEADER_SIZE + MEMORY_DIAG_DUMP_SIZE];
+			char text[MEMORY_DIAG_TEXT_SIZE];
+			SARC::MemoryDiag::Dump(reply + REPORT_HEADER_SIZE);
+			Report(command.opcode, reply, MEMORY_DIAG_DUMP_SIZE);
+			SARC::MemoryDiag::Describe(text);
+			ShowStatus(text);
+			break;
+		}
+
+		case CLOOP_STATS_RESET:
+			loopStats.Reset();
+			scheduler.ResetStats();
+			Acknowledge(command.opcode, "Loop stats reset.");
+			break;
+
+		case CTELEMETRY:
+			// One stream for every client that asks, at the period asked for last.
+			session->telemetry = (command.arg1 != 0);
+			if (session->telemetry)
+			{
+				// Starts with a keyframe, so the newcomer has every field.
+				telemetry.SetPeriod(command.arg1 * 1000UL);
+				scheduler.SetPeriod(telemetryTask, telemetry.GetPeriod());
+				scheduler.Arm(telemetryTask, 0);
+			}
+			else if (TelemetrySessions() == 0)
+			{
+				telemetry.SetPeriod(0);
+				scheduler.Disarm(telemetryTask);
+			}
+			Acknowledge(command.opcode, "Telemetry set.");
+			break;
+
+		case CREPLY_VERBOSE:
+			session->replyMode = SARC::replyVerbose;
+			Acknowledge(command.opcode, "Verbose replies.");
+			break;
+
+		case CREPLY_COMPACT:
+			session->replyMode = SARC::replyCompact;
+			Acknowledge(command.opcode, "Compact replies.");
+			break;
+
+		case CREPLY_SILENT:
+			session->replyMode = SARC::replySilent;
+			Acknowledge(command.opcode, "Silent replies.");
+			break;
+
+		case PROTOCOL_MODE_BINARY:
+			// Binary clients parse status codes, not text.
+			session->replyMode = SARC::replyCompact;
+			Acknowledge(command.opcode, "Binary mode.");
+			break;
+
+		case CMODE_LEGACY:
+			// Binary telemetry would garble a text client's output.
+			session->telemetry = false;
+			session->replyMode = SARC::replyVerbose;
+			Acknowledge(command.opcode, "Legacy mode.");
+			break;
+
+		default:
+			char unrecognized[] = "Unrecognized command: ?";
+			unrecognized[sizeof(unrecognized) - 2] = command.opcode;
+			Reject(STATUS_UNRECOGNIZED, command.opcode, unrecognized);
+			break;
+	}
+}
+
+/*
+ * Shows a status line on the LCD. This only queues the text; it is sent by
+ * DisplayRefreshTask(), so it costs the same with or without an LCD. Lines
+ * that scroll off before they were sent are never sent at all.
+ */
+void ShowStatus(const char* text)
+{
+	#ifdef USE_LCD
+		display->PrintLine(text);
+	#endif
+}
+
+/*
+ * Tracks the connection and processes at most INTAKE_BYTES_PER_PASS received
+ * bytes, so a burst of input can't starve the other tasks. Observers' input
+ * is processed even when no client is in control.
+ */
+void CommandIntakeTask(void)
+{
+	connection->Poll();
+
+	uint8_t opened;
+	uint8_t dropped;
+	uint8_t status;
+	const uint8_t* data;
+	uint8_t budget = INTAKE_BYTES_PER_PASS;
+	uint8_t count;
+
+	while (connection->TakeDeliveryStatus(status))
+	{
+		if (status == CONNECTION_DELIVERED)
+			deliveryFailures = 0;
+		else if (deliveryFailures < LINK_MAX_FAILURES)
+			deliveryFailures++;
+	}
+
+	while (connection->TakeOpenedSession(opened))
+	{
+		sessions[opened] = ClientSession();
+	}
+
+	while (connection->TakeDroppedSession(dropped))
+	{
+		connection->Select(dropped);
+		session = &sessions[dropped];
+		Reject(STATUS_BAD_LENGTH, 0, "Packet too long.");
+	}
+
+	TrackClient();
+
+	while (budget > 0 && (count = connection->Receive(data, budget)) > 0)
+	{
+		budget -= count;
+		session = &sessions[connection->GetSession()];
+		if (connection->StartsDatagram())
+		{
+			// Frames don't continue from one datagram to the next.
+			session->parser.Resynchronize();
+		}
+		if (connection->IsController())
+		{
+			// Something got through, so the link is alive. Take the client
+			// back before its commands are handled.
+			scheduler.Arm(heartbeatTask, HEARTBEAT_TIMEOUT * 1000UL);
+			if (heartbeatLost || deliveryFailures != 0)
+			{
+				heartbeatLost = false;
+				deliveryFailures = 0;
+				TrackClient();
+			}
+		}
+		ProcessInput(data, count);
+	}
+}
+
+/*
+ * Notices the client in control coming and going. It is gone when the
+ * connection says so, when its radio stops acknowledging (USE_XBEE_API), or
+ * when it has gone quiet for HEARTBEAT_TIMEOUT.
+ */
+void TrackClient(void)
 {
-	unsigned long millisNow = millis();	// This will be close enough for our purposes.
+	bool connected = connection->ClientIsConnected()
+					 && deliveryFailures < LINK_MAX_FAILURES
+					 && !heartbeatLost;
 
-	if (!displayedWaitingMessage)
+	if (connected == clientConnected) return;
+
+	clientConnected = connected;
+	if (connected)
 	{
 		#ifdef DEBUG
-			Serial.println("Waiting for client.");
+			Serial.println("Client acquired.");
 		#endif
-		#ifdef USE_LCD
-				display->PrintLine("Waiting for client.");
+		ShowStatus("Client acquired.");
+		#ifdef USE_BACKTRACK
+			// The client takes over right away, even in the middle of a segment.
+			backtrack.Abort(*motor, micros());
 		#endif
-		displayedWaitingMessage = true;
+		scheduler.Disarm(backtrackTask);
 	}
-
-	// if client found, begin parsing robot control commands
-	if (connection->ClientIsConnected())
+	else
 	{
 		#ifdef DEBUG
-			Serial.println("Client acquired.");
+			Serial.println("Connection terminated.");
 		#endif
-		#ifdef USE_LCD
-			display->PrintLine("Client acquired.");
+		ShowStatus("Conn terminated.");
+		scheduler.Arm(backtrackTask, TIME_UNTIL_BACKTRACK * 1000UL);
+	}
+}
+
+/*
+ * Decodes bytes received from the current session, and processes every
+ * command of each completed frame.
+ */
+void ProcessInput(const uint8_t* data, uint8_t count)
+{
+	SARC::CommandParser& parser = session->parser;
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		#ifdef DEBUG
+			Serial.print("Received byte: ");
+			Serial.println((char)data[i]);
 		#endif
 
-		// process user input as long as connection persists
-		while (connection->ClientIsConnected())
+		switch (parser.Feed(data[i]))
 		{
-			millisNow = millis();
-//			ticksLastConnected = millisNow;
+			case SARC::parseReady:
+				SARC::Command command;
+				while (parser.NextCommand(command))
+				{
+					ProcessCommand(command);
+				}
+				break;
 
-			// check for user input
-			if (connection->ClientDataAvailable())
-			{
-				// read the next character from the input buffer
-				char c = connection->Read();
+			case SARC::parseBadLength:
+				Reject(STATUS_BAD_LENGTH, 0, "Bad frame length.");
+				break;
 
-				#ifdef DEBUG
-					Serial.print("Received command: ");
-					Serial.println(c);
-				#endif
+			case SARC::parseBadChecksum:
+				Reject(STATUS_BAD_CHECKSUM, 0, "Bad frame checksum.");
+				break;
 
-//				if (haveBacktrackIterator)
-//				{
-//					stateHistory->SetCurrent(backtrackIterator);
-//				}
+			case SARC::parseBadCommand:
+				Reject(STATUS_BAD_COMMAND, 0, "Bad command arguments.");
+				break;
 
-				// Process command
-				switch (c)
-				{
-					case CMAINTAIN:
-						lastMoveTime = millis();
-						connection->PrintLine("Maintaining current speed.");
-						break;
-
-					case CSTOP:
-						connection->PrintLine("Full Stop.");
-						motor->StopMovement();
-						#ifdef USE_LCD
-							display->PrintLine("Full Stop.");
-						#endif
-						break;
-
-					case CFORWARD:
-						connection->PrintLine("Accelerating.");
-						motor->AccelerateForward(delta);
-						#ifdef USE_LCD
-							display->PrintLine("Accelerating.");
-						#endif
-						break;
-
-					case CREVERSE:
-						connection->PrintLine("Decelerating.");
-						motor->AccelerateReverse(delta);
-						#ifdef USE_LCD
-							display->PrintLine("Decelerating.");
-						#endif
-						break;
-
-					case CLEFT:
-						connection->PrintLine("Turning left.");
-						motor->TurnLeft(delta);
-						#ifdef USE_LCD
-							display->PrintLine("Turning left.");
-						#endif
-						break;
-
-					case CRIGHT:
-						connection->PrintLine("Turning right.");
-						motor->TurnRight(delta);
-						#ifdef USE_LCD
-							display->PrintLine("Turning right.");
-						#endif
-						break;
-
-					case CFORWARD_FULL:
-						connection->PrintLine("Full forward.");
-						motor->MoveForwardFullSpeed();
-						#ifdef USE_LCD
-							display->PrintLine("Full forward.");
-						#endif
-						break;
-
-					case CREVERSE_FULL:
-						connection->PrintLine("Full reverse.");
-						motor->MoveReverseFullSpeed();
-						#ifdef USE_LCD
-							display->PrintLine("Full reverse.");
-						#endif
-						break;
-
-					case CLEFTFULL:
-						connection->PrintLine("Full left.");
-						motor->TurnLeftFullSpeed();
-						#ifdef USE_LCD
-							display->PrintLine("Full left.");
-						#endif
-						break;
-
-					case CRIGHTFULL:
-						connection->PrintLine("Full right.");
-						motor->TurnRightFullSpeed();
-						#ifdef USE_LCD
-							display->PrintLine("Full right.");
-						#endif
-						break;
-
-					case CBRAKE:
-						connection->PrintLine("Braking.");
-						motor->Brake();
-						#ifdef USE_LCD
-							display->PrintLine("Braking.");
-						#endif
-						break;
-
-					case CSTEER_CENTER:
-						connection->PrintLine("Centering.");
-						motor->SteerCenter();
-						#ifdef USE_LCD
-							display->PrintLine("Centering.");
-						#endif
-						break;
-
-					default:
-						connection->PrintLine("Unrecognized command: ");
-						connection->PrintLine((const char*)&c);
-						break;
-				}
-			}
-			else // no input from user to process
-			{
-				// stop movement if movement time limit exceeded
-				if (motor->IsMoving()) {
-					if (millisNow - lastMoveTime >= MOVEMENT_TIMEOUT) {
-						#ifdef USE_LCD
-							display->PrintLine("Movement timeout.");
-						#endif
-						#ifdef DEBUG
-							Serial.print("millisNow = "); Serial.print(millisNow);
-							Serial.print(", lastMoveTime = "); Serial.print(lastMoveTime);
-							Serial.print(", MOVEMENT_TIMEOUT = "); Serial.print(MOVEMENT_TIMEOUT);
-							Serial.println(" Movement timeout. Stopping.");
-						#endif
-						motor->StopMovement();
-					}
-				}
-			}
+			default:
+				break;
 		}
+	}
+}
+
+/*
+ * Stops the motors when the client is gone. With USE_BACKTRACK, once the
+ * client has been gone for TIME_UNTIL_BACKTRACK (see BacktrackStartTask()),
+ * the recorded path is retraced to get back in range. Each call only checks
+ * whether the current segment is over, so this never holds up the other
+ * tasks.
+ */
+void MotorUpdateTask(void)
+{
+	if (clientConnected) return;
+
+	#ifdef USE_BACKTRACK
+		if (backtrack.IsActive())
+		{
+			backtrack.Update(*motor, micros());
+			return;
+		}
+	#endif
 
+	if (motor->IsMoving())
+	{
+		motor->StopMovement();
+	}
+}
+
+/*
+ * Deadline task, armed when the client is lost: it has now been gone for
+ * TIME_UNTIL_BACKTRACK, so MotorUpdateTask() starts retracing the path.
+ */
+void BacktrackStartTask(void)
+{
+	#ifdef USE_BACKTRACK
+		if (clientConnected || !backtrack.Start(*motor, micros())) return;
 		#ifdef DEBUG
-			Serial.println("Connection terminated.");
+			Serial.println("Initiating return to backtrack!");
 		#endif
-		#ifdef USE_LCD
-			display->PrintLine("Conn terminated.");
+		ShowStatus("Backtracking.");
+	#endif
+}
+
+/*
+ * Deadline task, re-armed by every bit of input from the controller: it has
+ * sent nothing for HEARTBEAT_TIMEOUT, so it counts as gone until it does.
+ */
+void HeartbeatTask(void)
+{
+	heartbeatLost = true;
+	TrackClient();
+}
+
+/*
+ * Deadline task: stops the motors if they have been moving for
+ * MOVEMENT_TIMEOUT milliseconds without a command. It re-arms itself for
+ * the moment the current movement would expire, so the check happens on
+ * time no matter how much input is arriving.
+ */
+void MovementTimeoutTask(void)
+{
+	uint32_t elapsed = millis() - lastMoveTime;
+
+	#ifdef USE_BACKTRACK
+		// Backtrack segments can be longer than the timeout; the engine stops by itself.
+		if (backtrack.IsActive()) elapsed = 0;
+	#endif
+
+	if (motor->IsMoving() && elapsed >= MOVEMENT_TIMEOUT)
+	{
+		ShowStatus("Movement timeout.");
+		#ifdef DEBUG
+			Serial.print("elapsed = "); Serial.print(elapsed);
+			Serial.print(", MOVEMENT_TIMEOUT = "); Serial.print(MOVEMENT_TIMEOUT);
+			Serial.println(" Movement timeout. Stopping.");
 		#endif
 		motor->StopMovement();
+		elapsed = 0;
+	}
+	else if (!motor->IsMoving())
+	{
+		elapsed = 0;
+	}
+
+	scheduler.Arm(timeoutTask, (MOVEMENT_TIMEOUT - elapsed) * 1000UL);
+}
+
+/*
+ * Sends some of the queued LCD output, without blocking.
+ */
+void DisplayRefreshTask(void)
+{
+	#ifdef USE_LCD
+		display->Update();
+	#endif
+}
+
+/*
+ * The clients that asked for telemetry and are still connected: a bit
+ * (1 << session) for each.
+ */
+uint8_t TelemetrySessions(void)
+{
+	uint8_t recipients = 0;
+	for (uint8_t i = 0; i < CONNECTION_MAX_SESSIONS; i++)
+	{
+		if (sessions[i].telemetry) recipients |= (1 << i);
+	}
+	return recipients & connection->GetOpenSessions();
+}
+
+/*
+ * Sends a telemetry frame to every client that asked for it, and slows down
+ * (or speeds back up) depending on how long the link took to take it. See
+ * Telemetry.h. Stops when the last of those clients is gone.
+ */
+void TelemetryTask(void)
+{
+	SARC::TelemetrySample sample;
+	uint8_t reply[REPORT_HEADER_SIZE + TELEMETRY_MAX_SIZE];
+	uint8_t recipients = TelemetrySessions();
+
+	if (recipients == 0)
+	{
+		telemetry.SetPeriod(0);
+		scheduler.Disarm(telemetryTask);
+		return;
 	}
 
-	/******* If we're here, we're not connected *******/
-//	if (SARC::timeDifference(ticksLastConnected, millisNow) >= TIME_UNTIL_BACKTRACK)
-//	{
-//		if (inAutoMove == true)
-//		{
-//			Serial.print("automove time="); Serial.println(SARC::timeDifference(previousTicks, millisNow));
-//			if (SARC::timeDifference(previousTicks, millisNow) >= autoMoveExpires)
-//			{
-//				inAutoMove = false;
-//				#ifdef DEBUG
-//					Serial.println("AutoMove expired");
-//				#endif
-//			}
-//		}
-//		if (inAutoMove == false)
-//		{
-//			if (stateHistory->GetHistorySize() > 0)
-//			{
-//				/******* Return to sender :) *******/
-//				if (haveBacktrackIterator == false)
-//				{
-//					#ifdef DEBUG
-//						Serial.println("Initiating return to backtrack!");
-//					#endif
-//					backtrackIterator = stateHistory->BacktrackIterator(stateHistory->GetHistorySize());
-//					haveBacktrackIterator = true;
-//				}
-//
-//				backtrackIterator->CopyReverse(*backtrackIterator);
-//
-//				#ifdef DEBUG
-//					Serial.println("Calling SetSpeeds() with speeds from history.");
-//				#endif
-//				motor->SetSpeeds(backtrackIterator->getLeftSpeed(), backtrackIterator->getRightSpeed());
-//
-//				if (backtrackIterator != stateHistory->BacktrackIteratorEnd())
-//				{
-//					++backtrackIterator; // It's a reverse iterator, so incrementing goes to previous one. ;)
-//					autoMoveExpires = backtrackIterator->getDuration();
-//					inAutoMove = true;
-//					Serial.print("beginning automove for duration="); Serial.println(autoMoveExpires);
-//				}
-//				else
-//				{
-//					#ifdef DEBUG
-//						Serial.println("backtrackIterator depleted.");
-//					#endif
-//					motor->StopMovement();
-//				}
-//			} // if (stateHistory->GetHistorySize() > 0)
-//			else
-//			{
-//				motor->StopMovement();
-//			}
-//		} // if (inAutoMove == false)
-//	} 	// if (timeDifference(ticksLastConnected, millis()) >= TIME_UNTIL_BACKTRACK)
-//	previousTicks = millisNow;
+	sample.time = millis();
+	sample.leftSpeed = motor->GetLeftSpeed();
+	sample.rightSpeed = motor->GetRightSpeed();
+	sample.leftActual = motor->GetLeftActualSpeed();
+	sample.rightActual = motor->GetRightActualSpeed();
+	sample.flags = (motor->IsMoving() ? TELEMETRY_FLAG_MOVING : 0)
+				 | (clientConnected ? TELEMETRY_FLAG_CONNECTED : 0);
+	sample.sinceCommand = SARC::Clamp16(sample.time - lastCommandTime);
+	sample.loopMax = SARC::Clamp16(loopStats.GetMaxDuration());
+	sample.loopOverBudget = SARC::Clamp16(loopStats.GetOverBudget());
+
+	uint8_t length = telemetry.Encode(sample, reply + REPORT_HEADER_SIZE);
+	uint32_t start = micros();
+	Report(CTELEMETRY, reply, length, recipients);
+	unsigned long sendMicros = micros() - start;
+	if (deliveryFailures > 0) sendMicros = TELEMETRY_SLOW_SEND + 1;	// The link is worse than slow.
+	if (telemetry.Adapt(sendMicros))
+	{
+		scheduler.SetPeriod(telemetryTask, telemetry.GetPeriod());
+	}
+}
+
+void loop()
+{
+	loopStats.Mark(micros());
+	SARC::MemoryDiag::Sample();
+	scheduler.RunPending();
+	connection->FlushIfDue();
 }
@@ -32,6 +32,26 @@ void setup();
 #endif
 
 //add your function definitions for the project SARC here
+#include "Protocol.h"
+
+void ProcessInput(const uint8_t* data, uint8_t count);
+void ProcessCommand(const SARC::Command& command);
+void Acknowledge(char opcode, const char* text);
+void Reject(uint8_t status, char opcode, const char* text);
+void Report(char opcode, uint8_t* reply, uint8_t length, uint8_t recipients = 0);
+bool IsDrivingCommand(char opcode);
+uint8_t TelemetrySessions(void);
+void ShowStatus(const char* text);
+void TrackClient(void);
+
+// Scheduler tasks. See setup().
+void CommandIntakeTask(void);
+void MotorUpdateTask(void);
+void MovementTimeoutTask(void);
+void DisplayRefreshTask(void);
+void TelemetryTask(void);
+void HeartbeatTask(void);
+void BacktrackStartTask(void);
 
 
 
@@ -0,0 +1,206 @@
+/*
+ * Scheduler.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  See Scheduler.h
+ */
+
+#include "Scheduler.h"
+#include "Protocol.h"
+
+namespace SARC {
+
+// True if time has reached (or passed) due, taking clock wrap into account.
+#define TIME_REACHED(time, due) ((int32_t)((time) - (due)) >= 0)
+
+// The furthest ahead _nextDue can be and still compare correctly.
+#define SCHEDULER_MAX_DELAY	0x7FFFFFFFUL
+
+Scheduler::Scheduler(ClockFunction clock)
+{
+	_clock = clock;
+	_taskCount = 0;
+	_nextDue = _clock();
+}
+
+// Periodic tasks with a period of 0 run on every pass, so they aren't timers.
+bool Scheduler::IsTimer(const Task& task)
+{
+	return task.type == taskDeadline || task.period != 0;
+}
+
+// Makes sure the timers are checked once due is reached.
+void Scheduler::Schedule(uint32_t due)
+{
+	if (TIME_REACHED(_nextDue, due)) _nextDue = due;
+}
+
+uint8_t Scheduler::AddTask(const char* name, TaskFunction function, uint8_t type, unsigned long period, unsigned long budget)
+{
+	if (_taskCount >= SCHEDULER_MAX_TASKS) return SCHEDULER_NO_TASK;
+
+	Task& task = _tasks[_taskCount];
+	task.function = function;
+	task.name = name;
+	task.type = type;
+	task.period = period;
+	task.budget = budget;
+	task.due = _clock();
+	task.armed = (type == taskPeriodic);
+	task.stats.runs = 0;
+	task.stats.lastDuration = 0;
+	task.stats.maxDuration = 0;
+	task.stats.maxLateness = 0;
+	task.stats.overruns = 0;
+	if (task.armed) Schedule(task.due);
+	return _taskCount++;
+}
+
+uint8_t Scheduler::AddPeriodic(const char* name, TaskFunction function, unsigned long periodMicros, unsigned long budgetMicros)
+{
+	return AddTask(name, function, taskPeriodic, periodMicros, budgetMicros);
+}
+
+uint8_t Scheduler::AddDeadline(const char* name, TaskFunction function, unsigned long budgetMicros)
+{
+	return AddTask(name, function, taskDeadline, 0, budgetMicros);
+}
+
+void Scheduler::Arm(uint8_t taskId, unsigned long delayMicros)
+{
+	if (taskId >= _taskCount) return;
+	_tasks[taskId].due = _clock() + delayMicros;
+	_tasks[taskId].armed = true;
+	Schedule(_tasks[taskId].due);
+}
+
+void Scheduler::Disarm(uint8_t taskId)
+{
+	if (taskId >= _taskCount) return;
+	_tasks[taskId].armed = false;
+}
+
+/*
+ * Tasks still run in the order they were added. The timers are only looked
+ * at when the earliest of them is due; _nextDue is then worked out again
+ * from the ones that are still waiting, and Arm() brings it forward for any
+ * timer a task arms meanwhile. A timer that is disarmed may leave _nextDue
+ * early, which only costs a look at the timers for nothing.
+ */
+void Scheduler::RunPending(void)
+{
+	uint32_t now = _clock();
+	bool timersDue = TIME_REACHED(now, _nextDue);
+
+	if (timersDue) _nextDue = now + SCHEDULER_MAX_DELAY;
+
+	for (uint8_t i = 0; i < _taskCount; i++)
+	{
+		Task& task = _tasks[i];
+
+		if (!task.armed) continue;
+		if (IsTimer(task))
+		{
+			if (!timersDue) continue;
+			if (!TIME_REACHED(now, task.due))
+			{
+				Schedule(task.due);
+				continue;
+			}
+		}
+
+		RunTask(task);
+		if (task.armed && IsTimer(task)) Schedule(task.due);
+	}
+}
+
+/*
+ * A periodic task that falls more than a whole period behind is not run
+ * several times to "catch up". It skips the missed periods instead, which
+ * is what you want for polling and display work.
+ *
+ * Tasks that run on every pass have no due time, so they can't be late.
+ */
+void Scheduler::RunTask(Task& task)
+{
+	uint32_t start = _clock();
+	uint32_t lateness = IsTimer(task) ? start - task.due : 0;
+
+	if (task.type == taskPeriodic)
+	{
+		task.due += task.period;
+		if (TIME_REACHED(start, task.due)) task.due = start + task.period;
+	}
+	else
+	{
+		task.armed = false;		// The task may re-arm itself.
+	}
+
+	task.function();
+
+	uint32_t duration = _clock() - start;
+	task.stats.runs++;
+	task.stats.lastDuration = duration;
+	if (duration > task.stats.maxDuration) task.stats.maxDuration = duration;
+	if (lateness > task.stats.maxLateness) task.stats.maxLateness = lateness;
+	if (duration > task.budget) task.stats.overruns++;
+}
+
+void Scheduler::SetPeriod(uint8_t taskId, unsigned long periodMicros)
+{
+	if (taskId >= _taskCount) return;
+	_tasks[taskId].period = periodMicros;
+	if (_tasks[taskId].armed) Schedule(_tasks[taskId].due);
+}
+
+uint8_t Scheduler::GetTaskCount(void)
+{
+	return _taskCount;
+}
+
+const char* Scheduler::GetName(uint8_t taskId)
+{
+	if (taskId >= _taskCount) return "";
+	return _tasks[taskId].name;
+}
+
+const TaskStats& Scheduler::GetStats(uint8_t taskId)
+{
+	if (taskId >= _taskCount) taskId = 0;
+	return _tasks[taskId].stats;
+}
+
+void Scheduler::ResetStats(void)
+{
+	for (uint8_t i = 0; i < _taskCount; i++)
+	{
+		_tasks[i].stats.runs = 0;
+		_tasks[i].stats.lastDuration = 0;
+		_tasks[i].stats.maxDuration = 0;
+		_tasks[i].stats.maxLateness = 0;
+		_tasks[i].stats.overruns = 0;
+	}
+}
+
+uint8_t Scheduler::Dump(uint8_t* buffer)
+{
+	uint8_t* start = buffer;
+
+	*buffer++ = _taskCount;
+	for (uint8_t i = 0; i < _taskCount; i++)
+	{
+		const TaskStats& stats = _tasks[i].stats;
+		buffer = PutLong(buffer, stats.runs);
+		buffer = PutInt(buffer, Clamp16(_tasks[i].budget));
+		buffer = PutInt(buffer, Clamp16(stats.maxDuration));
+		buffer = PutInt(buffer, Clamp16(stats.maxLateness));
+		buffer = PutInt(buffer, stats.overruns);
+	}
+	return (uint8_t)(buffer - start);
+}
+
+#undef TIME_REACHED
+#undef SCHEDULER_MAX_DELAY
+
+} /* namespace SARC */
@@ -0,0 +1,122 @@
+/*
+ * Scheduler.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  A very small cooperative scheduler. loop() calls RunPending() and every
+ *  task that is due runs once, to completion. Nothing is pre-empted, so
+ *  each task is expected to do a bounded amount of work per call (e.g.
+ *  read at most a few bytes) and come back on its next turn.
+ *
+ *  Two kinds of tasks are supported:
+ *  	Periodic - runs every periodMicros. A period of 0 runs it on every pass.
+ *  	Deadline - runs once, when the time given to Arm() has passed. The task
+ *  	           may re-arm itself.
+ *
+ *  Deadline tasks and periodic tasks with a period are timers. The scheduler
+ *  keeps the earliest time any of them is due, so a pass where none is due
+ *  costs one comparison for all of them, however many there are and however
+ *  much input the other tasks are working through. The clock is read once
+ *  per pass for that, and again only around each task that runs.
+ *
+ *  The clock is passed in, rather than calling micros() directly, so the
+ *  scheduler can be built on a host with a fake clock. All time comparisons
+ *  are wrap-safe, as long as no period or deadline exceeds half the range of
+ *  the clock (about 35 minutes for micros()).
+ *
+ *  Every task keeps timing statistics, so the cost of each part of the
+ *  control loop can be measured. Dump() writes them for the CTASK_STATS reply
+ *  (see Protocol.h), in the order the tasks were added. Every field is
+ *  little-endian, and times are in microseconds:
+ *
+ *  	[TASKS:1] then for each task:
+ *  	[RUNS:4] [BUDGET:2] [MAX DURATION:2] [MAX LATENESS:2] [OVERRUNS:2]
+ *
+ *  The 2-byte fields stop at 65535.
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdint.h>
+
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS	7
+#endif
+
+#define SCHEDULER_NO_TASK	0xFF
+#define SCHEDULER_DUMP_SIZE	(1 + 12 * SCHEDULER_MAX_TASKS)
+
+namespace SARC {
+
+typedef uint32_t (*ClockFunction)(void);
+typedef void (*TaskFunction)(void);
+
+enum TaskType
+{
+	taskPeriodic = 0,
+	taskDeadline
+};
+
+struct TaskStats
+{
+	unsigned long runs;
+	unsigned long lastDuration;		// Microseconds
+	unsigned long maxDuration;		// Microseconds
+	unsigned long maxLateness;		// Microseconds between due time and actual start. Timers only.
+	unsigned int overruns;			// Runs that took longer than the task's budget
+};
+
+class Scheduler
+{
+public:
+	Scheduler(ClockFunction clock);
+
+	// The name is only kept (not copied) for reports, so pass a literal.
+	// @return: The task id, or SCHEDULER_NO_TASK if the task table is full.
+	uint8_t AddPeriodic(const char* name, TaskFunction function, unsigned long periodMicros, unsigned long budgetMicros);
+	uint8_t AddDeadline(const char* name, TaskFunction function, unsigned long budgetMicros);
+
+	// Deadline tasks are idle until armed. Arming again moves the deadline.
+	void Arm(uint8_t taskId, unsigned long delayMicros);
+	void Disarm(uint8_t taskId);
+
+	// Changes the period of a periodic task. Takes effect after its next run.
+	void SetPeriod(uint8_t taskId, unsigned long periodMicros);
+
+	// Runs every task that is due. Call this from loop().
+	void RunPending(void);
+
+	uint8_t GetTaskCount(void);
+	const char* GetName(uint8_t taskId);
+	const TaskStats& GetStats(uint8_t taskId);
+	void ResetStats(void);
+	// @return: The number of bytes written, at most SCHEDULER_DUMP_SIZE.
+	uint8_t Dump(uint8_t* buffer);
+
+private:
+	struct Task
+	{
+		TaskFunction function;
+		const char* name;
+		unsigned long period;
+		uint32_t due;
+		unsigned long budget;
+		uint8_t type;
+		bool armed;
+		TaskStats stats;
+	};
+
+	uint8_t AddTask(const char* name, TaskFunction function, uint8_t type, unsigned long period, unsigned long budget);
+	void RunTask(Task& task);
+	static bool IsTimer(const Task& task);
+	void Schedule(uint32_t due);
+
+	ClockFunction _clock;
+	uint32_t _nextDue;			// No timer is due before this.
+	Task _tasks[SCHEDULER_MAX_TASKS];
+	uint8_t _taskCount;
+};
+
+} /* namespace SARC */
+#endif /* SCHEDULER_H_ */
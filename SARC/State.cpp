@@ -21,22 +21,11 @@
  *
  */
 
-#include <iterator>
-#include <vector>
-#include <map>
-//#include "pnew.cpp"
-#include "pnew.h"
-#include <algorithm>
-
 #include "State.h"
 #include "MotorDefs.h"
 #include "ArduinoUtils.h"
 #include "Arduino.h"
 
-#ifndef MAX_HISTORY
-#define MAX_HISTORY 5
-#endif
-
 
 namespace SARC {
 
@@ -55,16 +44,15 @@ State::State(const State& state)
 	_duration = state._duration;
 	_leftSpeed = state._leftSpeed;
 	_rightSpeed = state._rightSpeed;
-	_previousTick = state._previousTick;
 }
 
-State::State(unsigned int newDirection = 0, unsigned long newDuration = 0,
-		unsigned int newLeftSpeed = MotorDefs::neutral , unsigned int newRightSpeed = MotorDefs::neutral)
+State::State(unsigned int newDirection, unsigned long newDuration,
+		unsigned int newLeftSpeed, unsigned int newRightSpeed)
 {
 	_direction = newDirection;
 	_leftSpeed = newLeftSpeed;
 	_rightSpeed = newRightSpeed;
-	_previousTick = micros();
+	setDuration(newDuration);
 }
 
 int State::getDirection(void)
@@ -80,9 +68,43 @@ bool State::isRightForward(void) {return _rightSpeed > MotorDefs::neutral;}
 
 int State::getRightSpeed(void) {return _rightSpeed;}
 
-void State::setDuration(unsigned long duration) {_duration = duration;}
+/*
+ * The duration (microseconds) is stored as a 12-bit mantissa and a 4-bit
+ * exponent. Anything up to 4095 us is exact. Above that the mantissa is at
+ * least 2048 and rounding is off by at most half a step, so the relative
+ * error is at most 1/4096 (e.g. +/- 1.2 ms for a 5 second segment). Durations
+ * longer than STATE_MAX_DURATION (~134 seconds) are saturated.
+ */
+void State::setDuration(unsigned long duration)
+{
+	if (duration >= STATE_MAX_DURATION)
+	{
+		_duration = 0xFFFF;
+		return;
+	}
+
+	uint8_t exponent = 0;
+	while ((duration >> exponent) >= (1UL << STATE_MANTISSA_BITS))
+	{
+		exponent++;
+	}
+	if (exponent > 0)
+	{
+		// Round to nearest. This can carry into the next exponent.
+		duration = (duration + (1UL << (exponent - 1))) >> exponent;
+		if (duration >= (1UL << STATE_MANTISSA_BITS))
+		{
+			duration >>= 1;
+			exponent++;
+		}
+	}
+	_duration = (uint16_t)((exponent << STATE_MANTISSA_BITS) | duration);
+}
 
-unsigned long State::getDuration(void) {return _duration;}
+unsigned long State::getDuration(void)
+{
+	return (unsigned long)(_duration & ((1U << STATE_MANTISSA_BITS) - 1)) << (_duration >> STATE_MANTISSA_BITS);
+}
 
 // For equality, we only compare the _direction and speed(s) - not duration.
 bool State::operator==(const State& state)
@@ -119,67 +141,105 @@ void State::CopyReverse(State& souceState)
 StateHistory::StateHistory(unsigned int historySize)
 {
 	SetHistorySize(historySize);
-	_previousTick = micros();
+	_currentStart = micros();
+	_currentOpen = false;
+	_recording = true;
 };
 
 unsigned int StateHistory::SetHistorySize(unsigned int historySize)
 {
-	_vector.resize(historySize);
-	return _vector.size();
+	_limit = (historySize > 0 && historySize < MAX_HISTORY) ? historySize : MAX_HISTORY;
+	while (_buffer.Size() > _limit)
+	{
+		_buffer.PopFront();
+	}
+	return _limit;
 }
 
 /*
  * Adds a State. This is done in an intelligent way by comparing the previous
- * state to the new one. If the States are different only by time, the
- * previous State is updated by adding the time (duration) of the two States.
- * The size of the wrapped vector is also managed. If the current size is >=
- * MAX_HISTORY, the oldest element is removed.
+ * state to the new one. If the States are different only by time, nothing
+ * changes - the previous State simply lasts longer. Otherwise the previous
+ * State gets its final duration and the new State is appended. Once the
+ * history is full, the oldest State is dropped. This is O(1) and never
+ * allocates.
  * @param: state A reference to a state object.
  * @return: size_t The number of States in this history.
  */
 int StateHistory::AddState(State state)
 {
-	unsigned long tickNow = micros();
-	State& prevState = _vector[_vector.size() - 1];
-	if (prevState == state)
-	{
-		prevState.setDuration( timeDifference(prevState.getDuration(), tickNow) );
-	}
-	else
+	if (!_recording) return _buffer.Size();
+
+	uint32_t tickNow = micros();
+
+	if (_currentOpen)
 	{
-		if (_vector.size() >= MAX_HISTORY)
+		State& prevState = _buffer.Back();
+		if (prevState == state)
 		{
-			_vector.erase(_vector.begin());
+			return _buffer.Size();
 		}
-		prevState.setDuration(timeDifference(prevState.getDuration(), timeDifference(_previousTick, tickNow)));
-		_vector.push_back(state);
+		// Packed only once, so repeated commands don't accumulate rounding error.
+		prevState.setDuration(tickNow - _currentStart);	// Unsigned math handles the rollover.
+	}
+	_currentStart = tickNow;
+	_currentOpen = true;
+
+	if (_buffer.Size() >= _limit)
+	{
+		_buffer.PopFront();
 	}
-	_previousTick = tickNow;
-	return _vector.size();
+	state.setDuration(0);
+	_buffer.PushBack(state);
+	return _buffer.Size();
 }
 
-std::vector<State>::reverse_iterator StateHistory::BacktrackIterator (unsigned int lastState)
+state_reverse_iterator StateHistory::BacktrackIterator (unsigned int lastState)
 {
-	return _vector.rbegin();
+	return _buffer.rbegin();
 }
 
-std::vector<State>::reverse_iterator StateHistory::BacktrackIteratorEnd ()
+state_reverse_iterator StateHistory::BacktrackIteratorEnd ()
 {
-	return _vector.rend();
+	return _buffer.rend();
 }
 
-void StateHistory::SetCurrent(std::vector<State>::reverse_iterator reverseIterator)
+/*
+ * Makes the State at reverseIterator the newest one by discarding the States
+ * that were recorded after it, e.g. the part of the path already backtracked.
+ */
+void StateHistory::SetCurrent(state_reverse_iterator reverseIterator)
 {
-	if (reverseIterator != _vector.rbegin() && reverseIterator != _vector.rend())
+	if (reverseIterator != _buffer.rbegin() && reverseIterator != _buffer.rend())
 	{
-		std::vector<State>::reverse_iterator riter = _vector.rbegin();
-		_vector.erase((State *)&(*riter), (State *)&(*reverseIterator));
+		_buffer.PopBack(reverseIterator.Offset());
+		_currentOpen = false;
 	}
 }
 
 unsigned int StateHistory::GetHistorySize(void)
 {
-	return _vector.size();
+	return _buffer.Size();
+}
+
+void StateHistory::EndCurrentState(void)
+{
+	if (_currentOpen)
+	{
+		_buffer.Back().setDuration(micros() - _currentStart);
+		_currentOpen = false;
+	}
+}
+
+void StateHistory::SetRecording(bool recording)
+{
+	_recording = recording;
+}
+
+void StateHistory::Clear(void)
+{
+	_buffer.Clear();
+	_currentOpen = false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
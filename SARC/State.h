@@ -8,28 +8,43 @@
 #ifndef STATE_H_
 #define STATE_H_
 
-#include <iterator>
-#include <vector>
-#include <map>
-#include <pnew.h>
-
-#include <algorithm>
+#include <stdint.h>
 
 #include "MotorDefs.h"
+#include "RingBuffer.h"
+
+// Number of States kept for backtracking. The storage is static (see
+// RingBuffer.h), so this costs MAX_HISTORY * sizeof(State) bytes of RAM.
 #ifndef MAX_HISTORY
-#define MAX_HISTORY 2
+#define MAX_HISTORY 32
 #endif
 
+/*
+ * A State is bit-packed to keep the history small: direction and both speeds
+ * share one 32-bit word and the duration is a 16-bit floating point value
+ * (see State::setDuration()). That's 6 bytes per State on AVR.
+ */
+#define STATE_DIRECTION_BITS	9		// 0 - 511, enough for 0 - 360 degrees
+#define STATE_SPEED_BITS		11		// 0 - 2047, enough for VEX (1000 - 2000) and AF (0 - 511)
+#define STATE_MANTISSA_BITS		12
+#define STATE_EXPONENT_BITS		4
+#define STATE_MAX_DURATION		(((1UL << STATE_MANTISSA_BITS) - 1) << ((1 << STATE_EXPONENT_BITS) - 1))	// ~134 seconds
+
 using namespace MotorDefs;
 
 namespace SARC {
 
+// These fail to compile if the MotorDefs in use don't fit the packed fields.
+typedef char StateForwardFitsPackedSpeed[((unsigned long)forward < (1UL << STATE_SPEED_BITS)) ? 1 : -1];
+typedef char StateReverseOfMinimumFitsPackedSpeed[((unsigned long)(2 * neutral - minimum) < (1UL << STATE_SPEED_BITS)) ? 1 : -1];
+
 
 class State {
 
 public:
 	State(const State& state);
-	State(unsigned int, unsigned long, unsigned int, unsigned int);
+	State(unsigned int newDirection = 0, unsigned long newDuration = 0,
+		  unsigned int newLeftSpeed = MotorDefs::neutral, unsigned int newRightSpeed = MotorDefs::neutral);
 
 	int getDirection(void);
 	bool isLeftForward(void);
@@ -52,35 +67,44 @@ public:
 	void CopyReverse(State& sourceState);
 
 private:
-	unsigned long _previousTick;
-	int _direction;				// Assumed to be 0 - 360 (degrees)
-	unsigned int _leftSpeed;
-	unsigned int _rightSpeed;
-	unsigned long _duration;
+	uint32_t _direction : STATE_DIRECTION_BITS;	// Assumed to be 0 - 360 (degrees)
+	uint32_t _leftSpeed : STATE_SPEED_BITS;
+	uint32_t _rightSpeed : STATE_SPEED_BITS;
+	uint16_t _duration;							// Mantissa in the low bits, exponent in the high bits.
 };
 
 
 ///////////////////////////////////////////////////////////////////////////////
 
-typedef std::vector<State>::reverse_iterator state_reverse_iterator;
+typedef RingBuffer<State, MAX_HISTORY> StateBuffer;
+typedef StateBuffer::reverse_iterator state_reverse_iterator;
 
 class StateHistory
 {
  public:
 	StateHistory(unsigned int);
-	unsigned int SetHistorySize(unsigned int);	// Reserves space in the wrapped vector.
+	unsigned int SetHistorySize(unsigned int);	// Limits the number of States kept (at most MAX_HISTORY).
 	unsigned int GetHistorySize(void);			// Returns the number of States that have been saved.
-	void SetCurrent(std::vector<State>::reverse_iterator);
+	void SetCurrent(state_reverse_iterator);
 
 	// Adds a State.
 	// @return: size_t The number of States in this history.
 	int AddState(State state);
-	std::vector<State>::reverse_iterator BacktrackIterator (unsigned int lastState);
-	std::vector<State>::reverse_iterator BacktrackIteratorEnd ();
+	state_reverse_iterator BacktrackIterator (unsigned int lastState);
+	state_reverse_iterator BacktrackIteratorEnd ();
+
+	// Gives the newest State its final duration, e.g. before backtracking.
+	void EndCurrentState(void);
+	// While not recording, AddState() is ignored. Used while replaying the history.
+	void SetRecording(bool recording);
+	void Clear(void);
 
  private:
-	std::vector<State> _vector;
-	unsigned long _previousTick;
+	StateBuffer _buffer;
+	unsigned int _limit;
+	uint32_t _currentStart;		// When the newest State began. Its duration isn't packed until it ends.
+	bool _currentOpen;				// False once the newest State's duration is final.
+	bool _recording;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
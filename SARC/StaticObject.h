@@ -0,0 +1,60 @@
+/*
+ * StaticObject.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Reserved static storage for one object that can't be constructed until
+ *  setup() runs (e.g. because its constructor talks to hardware). The
+ *  storage is part of the StaticObject, so a global StaticObject lands in
+ *  .bss and its size shows up in the RAM figure avr-size reports at link
+ *  time, instead of coming out of the heap at run time.
+ *
+ *  Construct() builds the object in place with the placement new from
+ *  pnew.cpp. It is meant to be called once, from setup(); the object is never
+ *  destroyed.
+ *
+ *  STATIC_RAM_CHECK() fails the build if an expression exceeds a budget, so
+ *  the total of the static objects can be checked at compile time, e.g.
+ *
+ *  	STATIC_RAM_CHECK(sizeof(a) + sizeof(b) <= 512, ObjectsFitBudget);
+ */
+
+#ifndef STATICOBJECT_H_
+#define STATICOBJECT_H_
+
+#include <stddef.h>
+#include "pnew.h"
+
+#define STATIC_RAM_CHECK(condition, name)	typedef char name[(condition) ? 1 : -1]
+
+namespace SARC {
+
+template <typename T>
+class StaticObject
+{
+public:
+
+	// @return: The constructed object.
+	T* Construct(void) { return new (_storage.bytes) T(); }
+
+	template <typename A1>
+	T* Construct(A1 a1) { return new (_storage.bytes) T(a1); }
+
+	template <typename A1, typename A2>
+	T* Construct(A1 a1, A2 a2) { return new (_storage.bytes) T(a1, a2); }
+
+private:
+
+	// The other members of the union only force the alignment. (On AVR,
+	// everything is byte aligned anyway.)
+	union
+	{
+		unsigned char bytes[sizeof(T)];
+		long alignLong;
+		double alignDouble;
+		void* alignPointer;
+	} _storage;
+};
+
+} /* namespace SARC */
+#endif /* STATICOBJECT_H_ */
@@ -0,0 +1,98 @@
+/*
+ * Telemetry.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  See Telemetry.h for the frame layout.
+ */
+
+#include "Telemetry.h"
+#include "Protocol.h"
+
+namespace SARC {
+
+Telemetry::Telemetry()
+{
+	_requestedPeriod = 0;
+	_period = 0;
+	_sequence = 0;
+	_quickSends = 0;
+	_keyframe = true;
+}
+
+void Telemetry::SetPeriod(unsigned long periodMicros)
+{
+	if (periodMicros != 0 && periodMicros < TELEMETRY_MIN_PERIOD) periodMicros = TELEMETRY_MIN_PERIOD;
+	if (periodMicros > TELEMETRY_MAX_PERIOD) periodMicros = TELEMETRY_MAX_PERIOD;
+
+	_requestedPeriod = periodMicros;
+	_period = periodMicros;
+	_quickSends = 0;
+	_keyframe = true;
+}
+
+unsigned long Telemetry::GetPeriod(void)
+{
+	return _period;
+}
+
+uint8_t Telemetry::Encode(const TelemetrySample& sample, uint8_t* buffer)
+{
+	uint8_t* start = buffer;
+	uint8_t fields = 0;
+
+	if (_keyframe || _sequence % TELEMETRY_KEYFRAME_INTERVAL == 0)
+	{
+		fields = 0xFF;
+		_keyframe = false;
+	}
+	else
+	{
+		if (sample.leftSpeed != _last.leftSpeed) fields |= telemetryLeftSpeed;
+		if (sample.rightSpeed != _last.rightSpeed) fields |= telemetryRightSpeed;
+		if (sample.leftActual != _last.leftActual) fields |= telemetryLeftActual;
+		if (sample.rightActual != _last.rightActual) fields |= telemetryRightActual;
+		if (sample.flags != _last.flags) fields |= telemetryFlags;
+		if (sample.sinceCommand != _last.sinceCommand) fields |= telemetrySinceCommand;
+		if (sample.loopMax != _last.loopMax) fields |= telemetryLoopMax;
+		if (sample.loopOverBudget != _last.loopOverBudget) fields |= telemetryLoopOverBudget;
+	}
+
+	*buffer++ = _sequence++;
+	*buffer++ = (uint8_t)sample.time;
+	*buffer++ = (uint8_t)(sample.time >> 8);
+	*buffer++ = (uint8_t)(sample.time >> 16);
+	*buffer++ = (uint8_t)(sample.time >> 24);
+	*buffer++ = fields;
+	if (fields & telemetryLeftSpeed) buffer = PutInt(buffer, sample.leftSpeed);
+	if (fields & telemetryRightSpeed) buffer = PutInt(buffer, sample.rightSpeed);
+	if (fields & telemetryLeftActual) buffer = PutInt(buffer, sample.leftActual);
+	if (fields & telemetryRightActual) buffer = PutInt(buffer, sample.rightActual);
+	if (fields & telemetryFlags) *buffer++ = sample.flags;
+	if (fields & telemetrySinceCommand) buffer = PutInt(buffer, sample.sinceCommand);
+	if (fields & telemetryLoopMax) buffer = PutInt(buffer, sample.loopMax);
+	if (fields & telemetryLoopOverBudget) buffer = PutInt(buffer, sample.loopOverBudget);
+
+	_last = sample;
+	return (uint8_t)(buffer - start);
+}
+
+bool Telemetry::Adapt(unsigned long sendMicros)
+{
+	if (_period == 0) return false;
+
+	if (sendMicros > TELEMETRY_SLOW_SEND)
+	{
+		_quickSends = 0;
+		if (_period >= TELEMETRY_MAX_PERIOD) return false;
+		_period = (_period * 2 < TELEMETRY_MAX_PERIOD) ? _period * 2 : TELEMETRY_MAX_PERIOD;
+		return true;
+	}
+
+	if (_period <= _requestedPeriod || ++_quickSends < TELEMETRY_RECOVER_FRAMES) return false;
+	_quickSends = 0;
+	_period = (_period / 2 > _requestedPeriod) ? _period / 2 : _requestedPeriod;
+	return true;
+}
+
+} /* namespace SARC */
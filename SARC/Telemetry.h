@@ -0,0 +1,111 @@
+/*
+ * Telemetry.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Periodic binary state reports, so a client can show what the robot is
+ *  doing without polling or parsing text. Telemetry is off until a client
+ *  sends CTELEMETRY with a period (see Protocol.h), and only goes to the
+ *  clients that did. Each one that asks restarts the stream with a keyframe
+ *  (below), at the period it asked for. Sending a period of 0, or leaving
+ *  binary mode, stops it for that client. Each frame is sent as a report,
+ *  [STATUS_OK][CTELEMETRY][LENGTH][DATA ...], with the data:
+ *
+ *  	[SEQUENCE:1] [TIME:4] [FIELDS:1] [FIELD ...]
+ *
+ *  SEQUENCE counts frames (and wraps), TIME is millis(). FIELDS has a bit
+ *  for each of the fields below, in this order, and only the fields whose
+ *  bit is set follow. A field is left out when it hasn't changed since the
+ *  last frame, except in every TELEMETRY_KEYFRAME_INTERVAL'th frame (and
+ *  the first one), which has all of them. All values are little-endian.
+ *
+ *  	telemetryLeftSpeed      2  Logical speeds (see MotorDefs.h)
+ *  	telemetryRightSpeed     2
+ *  	telemetryLeftActual     2  Speeds as sent to the motor driver
+ *  	telemetryRightActual    2
+ *  	telemetryFlags          1  TELEMETRY_FLAG_*
+ *  	telemetrySinceCommand   2  Milliseconds since the last command, up to 65535
+ *  	telemetryLoopMax        2  Longest pass of loop(), microseconds, up to 65535
+ *  	telemetryLoopOverBudget 2  Passes over budget, up to 65535 (see LoopStats.h)
+ *
+ *  The rate adapts to the link. Sending a frame that takes longer than
+ *  TELEMETRY_SLOW_SEND (because the Ethernet or serial buffer was full), or
+ *  while XBee packets aren't being delivered, doubles the period, up to
+ *  TELEMETRY_MAX_PERIOD. After TELEMETRY_RECOVER_FRAMES quick sends in a
+ *  row it is halved again, back down to the period the client asked for.
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+
+#define TELEMETRY_MIN_PERIOD		20000UL		// Microseconds (50 frames per second)
+#define TELEMETRY_MAX_PERIOD		2000000UL
+#define TELEMETRY_SLOW_SEND			2000UL		// Microseconds
+#define TELEMETRY_RECOVER_FRAMES	8
+#define TELEMETRY_KEYFRAME_INTERVAL	16
+#define TELEMETRY_MAX_SIZE			21			// Data bytes of a frame with every field
+#define TELEMETRY_FIELDS_OFFSET		5			// Where FIELDS is, in the data
+
+#define TELEMETRY_FLAG_MOVING		0x01
+#define TELEMETRY_FLAG_CONNECTED	0x02
+
+namespace SARC {
+
+enum TelemetryField
+{
+	telemetryLeftSpeed = 0x01,
+	telemetryRightSpeed = 0x02,
+	telemetryLeftActual = 0x04,
+	telemetryRightActual = 0x08,
+	telemetryFlags = 0x10,
+	telemetrySinceCommand = 0x20,
+	telemetryLoopMax = 0x40,
+	telemetryLoopOverBudget = 0x80
+};
+
+struct TelemetrySample
+{
+	uint32_t time;					// Milliseconds
+	unsigned int leftSpeed;
+	unsigned int rightSpeed;
+	unsigned int leftActual;
+	unsigned int rightActual;
+	uint8_t flags;
+	unsigned int sinceCommand;
+	unsigned int loopMax;
+	unsigned int loopOverBudget;
+};
+
+class Telemetry
+{
+public:
+	Telemetry();
+
+	// 0 turns telemetry off. Anything else is limited to TELEMETRY_MIN_PERIOD
+	// - TELEMETRY_MAX_PERIOD. The next frame has every field.
+	void SetPeriod(unsigned long periodMicros);
+
+	// The period after adapting to the link. 0 when off.
+	unsigned long GetPeriod(void);
+
+	// Writes the data of the next frame (at most TELEMETRY_MAX_SIZE bytes).
+	// @return: The number of bytes written.
+	uint8_t Encode(const TelemetrySample& sample, uint8_t* buffer);
+
+	// Adapts the period to how long the frame took to send.
+	// @return: true if the period changed.
+	bool Adapt(unsigned long sendMicros);
+
+private:
+	unsigned long _requestedPeriod;
+	unsigned long _period;
+	uint8_t _sequence;
+	uint8_t _quickSends;
+	bool _keyframe;			// The next frame has every field.
+	TelemetrySample _last;
+};
+
+} /* namespace SARC */
+#endif /* TELEMETRY_H_ */
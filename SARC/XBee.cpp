@@ -0,0 +1,55 @@
+/*
+ * XBee.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  See XBee.h for the frame layout.
+ */
+
+#include "XBee.h"
+
+namespace SARC {
+
+XBeeFrameWriter::XBeeFrameWriter(Print& out) : _out(out)
+{
+	_sum = 0;
+}
+
+void XBeeFrameWriter::Begin(uint16_t length)
+{
+	_out.write((uint8_t)XBEE_START);
+	WriteEscaped((uint8_t)(length >> 8));
+	WriteEscaped((uint8_t)length);
+	_sum = 0;
+}
+
+void XBeeFrameWriter::Write(uint8_t c)
+{
+	_sum += c;
+	WriteEscaped(c);
+}
+
+void XBeeFrameWriter::Write(const uint8_t* data, uint8_t length)
+{
+	for (uint8_t i = 0; i < length; i++)
+	{
+		Write(data[i]);
+	}
+}
+
+void XBeeFrameWriter::End(void)
+{
+	WriteEscaped(0xFF - _sum);
+}
+
+void XBeeFrameWriter::WriteEscaped(uint8_t c)
+{
+	if (c == XBEE_START || c == XBEE_ESCAPE || c == XBEE_XON || c == XBEE_XOFF)
+	{
+		_out.write((uint8_t)XBEE_ESCAPE);
+		c ^= XBEE_ESCAPE_XOR;
+	}
+	_out.write(c);
+}
+
+} /* namespace SARC */
@@ -0,0 +1,187 @@
+/*
+ * XBee.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  XBee (Series 1, 802.15.4) API mode frames, for Connection with
+ *  USE_XBEE_API. The radio must be set to escaped API mode (ATAP 2). Every
+ *  frame on the UART is
+ *
+ *  	[0x7E] [LENGTH:2, big endian] [FRAME DATA ...] [CHECKSUM]
+ *
+ *  The frame data starts with the API identifier (XBEE_API_*). CHECKSUM is
+ *  0xFF minus the low byte of the sum of the frame data. After the start
+ *  byte, every 0x7E, 0x7D, 0x11 and 0x13 is sent as 0x7D followed by the byte
+ *  XOR 0x20, so a 0x7E always starts a frame, and the parser gets back in
+ *  step with the next frame after noise.
+ *
+ *  Only what Connection needs is covered: receive packets (16 and 64-bit
+ *  source addresses), transmit requests and their status, and local AT
+ *  commands for setting the baud rate.
+ */
+
+#ifndef XBEE_H_
+#define XBEE_H_
+
+#include <stdint.h>
+#include <Print.h>
+
+#define XBEE_START			0x7E
+#define XBEE_ESCAPE			0x7D
+#define XBEE_XON			0x11
+#define XBEE_XOFF			0x13
+#define XBEE_ESCAPE_XOR		0x20
+
+// API identifiers
+#define XBEE_API_TX_64		0x00	// [id] [address:8] [options] [data]
+#define XBEE_API_TX_16		0x01	// [id] [address:2] [options] [data]
+#define XBEE_API_AT_COMMAND	0x08	// [id] [command:2] [value]
+#define XBEE_API_RX_64		0x80	// [address:8] [RSSI] [options] [data]
+#define XBEE_API_RX_16		0x81	// [address:2] [RSSI] [options] [data]
+#define XBEE_API_AT_RESPONSE	0x88	// [id] [command:2] [status] [value]
+#define XBEE_API_TX_STATUS	0x89	// [id] [status]
+
+// Transmit status
+#define XBEE_TX_SUCCESS		0
+#define XBEE_TX_NO_ACK		1		// The remote radio didn't acknowledge, after the retries.
+#define XBEE_TX_CCA_FAILURE	2		// The channel was never clear.
+#define XBEE_TX_PURGED		3
+
+#define XBEE_AT_OK			0
+#define XBEE_BROADCAST		0xFFFF	// 16-bit destination address
+#define XBEE_MAX_PAYLOAD	100		// RF data bytes per packet
+
+// What comes before the data in each kind of receive packet.
+#define XBEE_RX_16_HEADER	(1 + 2 + 2)		// API identifier, address, RSSI and options
+#define XBEE_RX_64_HEADER	(1 + 8 + 2)
+// A transmit request with a whole packet.
+#define XBEE_MAX_FRAME		(1 + 1 + 8 + 1 + XBEE_MAX_PAYLOAD)
+
+namespace SARC {
+
+enum XBeeParseResult
+{
+	xbeeIncomplete = 0,		// Need more bytes.
+	xbeeFrameReady,			// The frame data is available from GetData().
+	xbeeBadChecksum,		// Frame was discarded.
+	xbeeTooLong				// Frame was larger than CAPACITY, and discarded.
+};
+
+/*
+ * Decodes frames of up to CAPACITY bytes of frame data. The storage is part
+ * of the object (like RingBuffer), so each user sizes it for the frames it
+ * expects. Longer frames are checked, then reported as xbeeTooLong, with
+ * their first CAPACITY bytes in GetData().
+ */
+template <uint16_t CAPACITY>
+class XBeeFrameParser
+{
+public:
+	XBeeFrameParser() : _state(waitingForStart), _escaped(false), _length(0), _received(0), _sum(0) {}
+
+	/*
+	 * Feeds one byte from the UART to the parser. An unescaped start byte
+	 * always starts a new frame, even in the middle of one, so a frame cut
+	 * short by noise costs only itself.
+	 */
+	XBeeParseResult Feed(uint8_t c)
+	{
+		if (c == XBEE_START)
+		{
+			_state = waitingForLengthHigh;
+			_escaped = false;
+			return xbeeIncomplete;
+		}
+		if (_state == waitingForStart) return xbeeIncomplete;
+
+		if (c == XBEE_ESCAPE)
+		{
+			_escaped = true;
+			return xbeeIncomplete;
+		}
+		if (_escaped)
+		{
+			c ^= XBEE_ESCAPE_XOR;
+			_escaped = false;
+		}
+
+		switch (_state)
+		{
+			case waitingForLengthHigh:
+				_length = (uint16_t)c << 8;
+				_state = waitingForLengthLow;
+				break;
+
+			case waitingForLengthLow:
+				_length |= c;
+				_received = 0;
+				_sum = 0;
+				_state = (_length == 0) ? waitingForStart : readingData;
+				break;
+
+			case readingData:
+				if (_received < CAPACITY) _data[_received] = c;
+				_received++;
+				_sum += c;
+				if (_received == _length)
+					_state = waitingForChecksum;
+				break;
+
+			case waitingForChecksum:
+				_state = waitingForStart;
+				if ((uint8_t)(_sum + c) != 0xFF)
+					return xbeeBadChecksum;
+				if (_length > CAPACITY)
+					return xbeeTooLong;
+				return xbeeFrameReady;
+		}
+
+		return xbeeIncomplete;
+	}
+
+	// The frame data of the last good frame, API identifier first. Good until
+	// the next call to Feed(). GetLength() can be more than CAPACITY.
+	const uint8_t* GetData(void) const { return _data; }
+	uint16_t GetLength(void) const { return _length; }
+
+private:
+	enum ParserState
+	{
+		waitingForStart,
+		waitingForLengthHigh,
+		waitingForLengthLow,
+		readingData,
+		waitingForChecksum
+	};
+
+	uint8_t _state;
+	bool _escaped;			// The last byte was XBEE_ESCAPE.
+	uint16_t _length;
+	uint16_t _received;
+	uint8_t _sum;
+	uint8_t _data[CAPACITY];
+};
+
+/*
+ * Writes a frame to the radio, escaping as it goes: Begin() with the length
+ * of the frame data, then exactly that many bytes, then End().
+ */
+class XBeeFrameWriter
+{
+public:
+	XBeeFrameWriter(Print& out);
+
+	void Begin(uint16_t length);
+	void Write(uint8_t c);
+	void Write(const uint8_t* data, uint8_t length);
+	void End(void);
+
+private:
+	void WriteEscaped(uint8_t c);
+
+	Print& _out;
+	uint8_t _sum;
+};
+
+} /* namespace SARC */
+#endif /* XBEE_H_ */
@@ -0,0 +1,68 @@
+/*
+ * AFMotor.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host stand-in for the Adafruit motor shield library (DC motors only).
+ *  Each AF_DCMotor remembers its speed and the last run() command. The
+ *  74HC595 latch that AFMotorDriver writes directly is modeled from the pin
+ *  writes; see HostAFLatch() in HostHal.h.
+ */
+
+#ifndef HOST_AFMOTOR_H_
+#define HOST_AFMOTOR_H_
+
+#include <stdint.h>
+
+#define MOTOR12_64KHZ	1
+#define MOTOR12_8KHZ	2
+#define MOTOR12_2KHZ	3
+#define MOTOR12_1KHZ	4
+#define MOTOR34_64KHZ	1
+#define MOTOR34_8KHZ	2
+#define MOTOR34_1KHZ	3
+
+#define FORWARD		1
+#define BACKWARD	2
+#define BRAKE		3
+#define RELEASE		4
+
+// Bit positions in the 74HC595 latch
+#define MOTOR1_A	2
+#define MOTOR1_B	3
+#define MOTOR2_A	1
+#define MOTOR2_B	4
+#define MOTOR4_A	0
+#define MOTOR4_B	6
+#define MOTOR3_A	5
+#define MOTOR3_B	7
+
+// Latch pins
+#define MOTORLATCH	12
+#define MOTORCLK	4
+#define MOTORENABLE	7
+#define MOTORDATA	8
+
+class AF_DCMotor
+{
+public:
+	AF_DCMotor(uint8_t motorNumber, uint8_t frequency = MOTOR34_8KHZ);
+	void run(uint8_t command);
+	void setSpeed(uint8_t speed);
+
+	// Host only.
+	uint8_t speed(void) const { return _speed; }
+	uint8_t command(void) const { return _command; }
+	uint32_t lastWriteMicros(void) const { return _lastWrite; }
+
+private:
+	uint8_t _number;
+	uint8_t _speed;
+	uint8_t _command;
+	uint32_t _lastWrite;
+};
+
+// The AF_DCMotor for motor (1 - 4), or NULL.
+AF_DCMotor* HostFindDCMotor(uint8_t motorNumber);
+
+#endif /* HOST_AFMOTOR_H_ */
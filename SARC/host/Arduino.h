@@ -0,0 +1,50 @@
+/*
+ * Arduino.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host (Linux) stand-in for the Arduino core, for the host build only. See
+ *  HostHal.h. Only what SARC uses is here.
+ *
+ *  unsigned long is 64 bits on a 64 bit host, so millis() and micros()
+ *  return uint32_t instead, and wrap when the AVR's would: micros() after
+ *  about 71 minutes and millis() after about 49 days.
+ */
+
+#ifndef HOST_ARDUINO_H_
+#define HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <new>
+#include <avr/pgmspace.h>
+#include "WString.h"
+#include "Print.h"
+#include "HardwareSerial.h"
+
+#define HIGH	1
+#define LOW		0
+#define INPUT	0
+#define OUTPUT	1
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// There are no interrupts on the host.
+inline void noInterrupts(void) {}
+inline void interrupts(void) {}
+
+#endif /* HOST_ARDUINO_H_ */
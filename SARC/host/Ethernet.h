@@ -0,0 +1,71 @@
+/*
+ * Ethernet.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host stand-in for the Arduino 1.0 Ethernet library, backed by TCP
+ *  sockets. It behaves like the W5100: at most HOST_MAX_SOCKETS clients,
+ *  and EthernetServer::available() only returns a client once it has sent
+ *  something.
+ *
+ *  The server listens on the port given to its constructor, unless
+ *  HostEthernetSetPort() was called first (e.g. so telnet's port 23 doesn't
+ *  need root).
+ */
+
+#ifndef HOST_ETHERNET_H_
+#define HOST_ETHERNET_H_
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+#define HOST_MAX_SOCKETS	4
+
+class EthernetClass
+{
+public:
+	void begin(uint8_t* mac, uint8_t* ip, uint8_t* gateway = 0, uint8_t* subnet = 0);
+};
+
+extern EthernetClass Ethernet;
+
+class EthernetClient : public Print
+{
+public:
+	EthernetClient();
+	EthernetClient(uint8_t socket);
+
+	uint8_t connected(void);
+	int available(void);
+	int read(void);
+	int read(uint8_t* buffer, size_t size);
+	int peek(void);
+	void flush(void);
+	void stop(void);
+	virtual size_t write(uint8_t c);
+	virtual size_t write(const uint8_t* buffer, size_t size);
+	using Print::write;
+	operator bool(void);
+	bool operator==(const EthernetClient& other) const { return _socket == other._socket; }
+	bool operator!=(const EthernetClient& other) const { return _socket != other._socket; }
+
+private:
+	uint8_t _socket;
+};
+
+class EthernetServer
+{
+public:
+	EthernetServer(uint16_t port);
+
+	void begin(void);
+	EthernetClient available(void);
+
+private:
+	void accept(void);
+
+	uint16_t _port;
+	int _listener;
+};
+
+#endif /* HOST_ETHERNET_H_ */
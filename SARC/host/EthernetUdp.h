@@ -0,0 +1,61 @@
+/*
+ * EthernetUdp.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host stand-in for the Arduino 1.0 EthernetUDP class, on a UDP socket.
+ *  Like the W5100, parsePacket() takes one datagram at a time, and whatever
+ *  wasn't read of the previous one is dropped. Output is collected between
+ *  beginPacket() and endPacket() and sent as one datagram.
+ *
+ *  The port given to begin() is replaced by the one passed to
+ *  HostEthernetSetPort(), if any, as for the TCP server. When the server
+ *  isn't listening (HostEthernetSetListening()), a free port on the loopback
+ *  interface is taken instead; HostEthernetUdpPort() tells which. The
+ *  datagram buffers are outside the object (on the W5100 they're in the
+ *  chip), so it doesn't count against STATIC_OBJECT_BUDGET; they are shared,
+ *  so only one EthernetUDP can be in use at a time.
+ */
+
+#ifndef HOST_ETHERNETUDP_H_
+#define HOST_ETHERNETUDP_H_
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+#define HOST_UDP_MAX_PACKET	512
+
+class EthernetUDP : public Print
+{
+public:
+	EthernetUDP();
+
+	uint8_t begin(uint16_t port);
+	void stop(void);
+
+	// @return: The size of the next datagram, or 0 if none is waiting.
+	int parsePacket(void);
+	int available(void);
+	int read(void);
+	int read(uint8_t* buffer, size_t size);
+	IPAddress remoteIP(void);
+	uint16_t remotePort(void);
+
+	int beginPacket(IPAddress ip, uint16_t port);
+	int endPacket(void);
+	virtual size_t write(uint8_t c);
+	virtual size_t write(const uint8_t* buffer, size_t size);
+	using Print::write;
+
+private:
+	int _socket;
+	size_t _rxLength;
+	size_t _rxPosition;
+	IPAddress _remoteIP;
+	uint16_t _remotePort;
+	size_t _txLength;
+	IPAddress _txIP;
+	uint16_t _txPort;
+};
+
+#endif /* HOST_ETHERNETUDP_H_ */
@@ -0,0 +1,32 @@
+/*
+ * HardwareSerial.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host stand-in for the Arduino serial port. What is written is decoded as
+ *  serial LCD commands when LCD_IS_SERIAL is defined (see HostHal.h), and
+ *  copied to stdout when USE_XBEE is, or to the fake radio with USE_XBEE_API.
+ *  Received bytes come from HostSerialInject().
+ */
+
+#ifndef HOST_HARDWARESERIAL_H_
+#define HOST_HARDWARESERIAL_H_
+
+#include "Print.h"
+
+class HardwareSerial : public Print
+{
+public:
+	void begin(unsigned long baud);
+	void end(void);
+	int available(void);
+	int peek(void);
+	int read(void);
+	void flush(void);
+	virtual size_t write(uint8_t c);
+	using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif /* HOST_HARDWARESERIAL_H_ */
@@ -0,0 +1,206 @@
+/*
+ * HostArduino.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host versions of the Arduino core functions: the clock, the pins and
+ *  Print. See HostHal.h.
+ */
+
+#ifdef SARC_HOST
+
+#include <time.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "AFMotor.h"
+#include "HostHal.h"
+
+/************ Clock ************/
+
+static bool clockIsVirtual = false;
+static unsigned long virtualMicros = 0;
+
+static unsigned long RealMicros(void)
+{
+	static bool started = false;
+	static struct timespec start;
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (!started)
+	{
+		start = now;
+		started = true;
+	}
+	return (unsigned long)(now.tv_sec - start.tv_sec) * 1000000UL
+		+ (now.tv_nsec - start.tv_nsec) / 1000;
+}
+
+void HostClockSetVirtual(bool isVirtual)
+{
+	if (isVirtual && !clockIsVirtual)
+		virtualMicros = RealMicros();	// Time doesn't jump back.
+	clockIsVirtual = isVirtual;
+}
+
+bool HostClockIsVirtual(void)
+{
+	return clockIsVirtual;
+}
+
+void HostClockAdvance(unsigned long microseconds)
+{
+	if (clockIsVirtual)
+		virtualMicros += microseconds;
+}
+
+static unsigned long Micros(void)
+{
+	return clockIsVirtual ? virtualMicros : RealMicros();
+}
+
+uint32_t micros(void)
+{
+	return (uint32_t) Micros();
+}
+
+// Not micros() / 1000, which would wrap 1000 times as often.
+uint32_t millis(void)
+{
+	return (uint32_t) (Micros() / 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	if (clockIsVirtual)
+		virtualMicros += us;
+	else
+		usleep(us);
+}
+
+void delay(unsigned long ms)
+{
+	if (clockIsVirtual)
+		virtualMicros += ms * 1000;
+	else
+		usleep(ms * 1000);
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+	return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+/************ Pins ************/
+
+#define HOST_PIN_COUNT	70
+
+static uint8_t pinStates[HOST_PIN_COUNT];
+static uint8_t afShift = 0;
+static uint8_t afLatch = 0;
+static uint32_t afLatchMicros = 0;
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+/*
+ * The motor shield's 74HC595 is modeled here, because AFMotorDriver writes it
+ * through the pins: data is shifted in on the rising edge of MOTORCLK and
+ * appears on the outputs on the rising edge of MOTORLATCH.
+ */
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	if (pin >= HOST_PIN_COUNT) return;
+	HostClockAdvance(HOST_COST_DIGITAL_WRITE);
+	bool rising = (value != LOW && pinStates[pin] == LOW);
+	pinStates[pin] = (value != LOW) ? HIGH : LOW;
+
+	if (rising && pin == MOTORCLK)
+	{
+		afShift = (afShift << 1) | pinStates[MOTORDATA];
+	}
+	else if (rising && pin == MOTORLATCH)
+	{
+		afLatch = afShift;
+		afLatchMicros = micros();
+	}
+}
+
+int digitalRead(uint8_t pin)
+{
+	if (pin >= HOST_PIN_COUNT) return LOW;
+	return pinStates[pin];
+}
+
+uint8_t HostPinState(uint8_t pin)
+{
+	return (uint8_t) digitalRead(pin);
+}
+
+uint8_t HostAFLatch(void)
+{
+	return afLatch;
+}
+
+uint32_t HostAFLatchMicros(void)
+{
+	return afLatchMicros;
+}
+
+/************ Print ************/
+
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+	size_t n = 0;
+	while (size--)
+		n += write(*buffer++);
+	return n;
+}
+
+size_t Print::write(const char* text)
+{
+	return write((const uint8_t*) text, strlen(text));
+}
+
+size_t Print::printNumber(unsigned long n, int base)
+{
+	char buffer[8 * sizeof(long) + 1];
+	char* digit = &buffer[sizeof(buffer) - 1];
+	*digit = '\0';
+
+	if (base < 2) base = 10;
+	do
+	{
+		unsigned long remainder = n % base;
+		n /= base;
+		*--digit = remainder < 10 ? '0' + remainder : 'A' + remainder - 10;
+	} while (n != 0);
+
+	return write(digit);
+}
+
+size_t Print::print(const char* text) { return write(text); }
+size_t Print::print(char c) { return write((uint8_t) c); }
+size_t Print::print(unsigned char n, int base) { return printNumber(n, base); }
+size_t Print::print(unsigned int n, int base) { return printNumber(n, base); }
+size_t Print::print(unsigned long n, int base) { return printNumber(n, base); }
+size_t Print::print(int n, int base) { return print((long) n, base); }
+
+size_t Print::print(long n, int base)
+{
+	if (base == 10 && n < 0)
+		return print('-') + printNumber(-(unsigned long) n, 10);
+	return printNumber((unsigned long) n, base);
+}
+
+size_t Print::println(void) { return write("\r\n"); }
+size_t Print::println(const char* text) { return print(text) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(unsigned char n, int base) { return print(n, base) + println(); }
+size_t Print::println(int n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned int n, int base) { return print(n, base) + println(); }
+size_t Print::println(long n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned long n, int base) { return print(n, base) + println(); }
+
+#endif // SARC_HOST
@@ -0,0 +1,290 @@
+/*
+ * HostBench.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  main() for the command processing benchmark. Runs the real setup() and
+ *  loop() on the virtual clock, with a client connected through
+ *  HostEthernetConnect(), and feeds it synthetic command streams.
+ *
+ *  Each stream is run twice:
+ *  	Burst - every command is sent at once. Gives commands/s.
+ *  	Paced - one command every BENCH_PACE microseconds, like a joystick
+ *  	        client. Gives the latency of each command, from its byte being
+ *  	        sent to the end of its reply, and to the motor write for the
+ *  	        commands that changed the motors.
+ *  Bytes per command (reply to the client, and to the LCD) are counted over
+ *  the paced run, including LCD output that drains after the last command.
+ *  So are the track writes Motor made and skipped because nothing changed
+ *  (see Motor::GetCommittedWrites()). The scheduler's task statistics, over
+ *  all the streams, follow the table.
+ *
+ *  All times are virtual (see HostHal.h), so every run gives the same
+ *  results. They are estimates of the time the AVR spends on I/O; the SARC
+ *  code's own run time is only covered by BENCH_PASS_COST. Build with and
+ *  without USE_LCD to compare ("make bench" does both).
+ *
+ *  Usage: sarc-bench [-n commands]
+ *  	-n	Commands per stream. Default BENCH_DEFAULT_COMMANDS.
+ */
+
+#ifdef SARC_HOST
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "SARC.h"
+#include "MotorDefs.h"
+#include "Motor.h"
+#include "Scheduler.h"
+#include "HostHal.h"
+#include "Servo.h"
+#include "AFMotor.h"
+
+#ifndef USE_ETHERNET
+#error "The benchmark connects its client over Ethernet. Build it with USE_ETHERNET."
+#endif
+
+#define BENCH_DEFAULT_COMMANDS	1000
+#define BENCH_PASS_COST			20UL		// Microseconds per pass of loop(), for the code itself
+#define BENCH_PACE				20000UL		// 50 commands per second
+#define BENCH_SETTLE			500000UL	// Time for queued LCD output to drain
+#define BENCH_MAX_WAIT			1000000UL	// Give up on a reply after this long
+
+struct Scenario
+{
+	const char* name;
+	const char* pattern;	// Repeated to make up the stream.
+};
+
+static const Scenario scenarios[] =
+{
+	{ "w/s/a/d bursts",	"wwwwaaaassssdddd" },
+	{ "mix with q",		"wawdqswsdqwwaq" },
+	{ "full speed",		"WqSqAqDq" }
+};
+
+extern SARC::RobotMotor* motor;
+extern SARC::Scheduler scheduler;
+
+static int client = -1;
+static unsigned long linesReceived = 0;
+
+// Reads whatever the robot has sent.
+// @return: Reply lines received so far.
+static unsigned long ReadReplies(void)
+{
+	char buffer[256];
+	ssize_t n;
+
+	while ((n = recv(client, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0)
+	{
+		for (ssize_t i = 0; i < n; i++)
+		{
+			if (buffer[i] == '\n') linesReceived++;
+		}
+	}
+	return linesReceived;
+}
+
+static void Send(const std::string& commands)
+{
+	if (send(client, commands.data(), commands.size(), 0) != (ssize_t) commands.size())
+	{
+		perror("sarc-bench: send");
+		exit(1);
+	}
+}
+
+static void Pass(void)
+{
+	loop();
+	HostClockAdvance(BENCH_PASS_COST);
+}
+
+static void RunFor(unsigned long microseconds)
+{
+	uint32_t start = micros();
+	while (micros() - start < microseconds) Pass();
+}
+
+// Runs loop() until there have been lines replies in total.
+static void RunUntilReplies(unsigned long lines)
+{
+	uint32_t start = micros();
+	while (ReadReplies() < lines)
+	{
+		if (micros() - start > BENCH_MAX_WAIT)
+		{
+			fprintf(stderr, "sarc-bench: no reply after %lu us\n", BENCH_MAX_WAIT);
+			exit(1);
+		}
+		Pass();
+	}
+}
+
+// When the later of the two tracks was last written. 0 if that can't be told.
+static uint32_t LastMotorWrite(void)
+{
+	#if defined(USE_MOCK_MOTORS)
+		return 0;
+	#elif defined(USE_SERVOS)
+		Servo* left = HostFindServo(PIN_LEFT_SERVO);
+		Servo* right = HostFindServo(PIN_RIGHT_SERVO);
+		if (!left || !right) return 0;
+		return std::max(left->lastWriteMicros(), right->lastWriteMicros());
+	#else
+		AF_DCMotor* left = HostFindDCMotor(AF_MOTOR_LEFT);
+		AF_DCMotor* right = HostFindDCMotor(AF_MOTOR_RIGHT);
+		if (!left || !right) return 0;
+		return std::max(left->lastWriteMicros(), right->lastWriteMicros());
+	#endif
+}
+
+static unsigned long LcdBytes(void)
+{
+	#if defined(USE_LCD) && defined(LCD_IS_SERIAL)
+		return HostSerialBytesWritten();
+	#elif defined(USE_LCD)
+		return HostLcdScreen().bytes;
+	#else
+		return 0;
+	#endif
+}
+
+static void PrintPercentiles(std::vector<unsigned long>& samples)
+{
+	if (samples.empty())
+	{
+		printf(" %7s %7s %7s", "-", "-", "-");
+		return;
+	}
+	std::sort(samples.begin(), samples.end());
+	printf(" %7lu %7lu %7lu",
+		samples[(samples.size() - 1) * 50 / 100],
+		samples[(samples.size() - 1) * 99 / 100],
+		samples.back());
+}
+
+// Stops the robot and lets the LCD catch up, so every run starts the same.
+static void Rest(void)
+{
+	Send("q");
+	RunUntilReplies(linesReceived + 1);
+	RunFor(BENCH_SETTLE);
+}
+
+static void RunScenario(const Scenario& scenario, unsigned int commands)
+{
+	std::string stream;
+	std::vector<unsigned long> dispatch;
+	std::vector<unsigned long> motorWrite;
+
+	for (size_t i = 0; stream.size() < commands; i++)
+	{
+		stream += scenario.pattern[i % strlen(scenario.pattern)];
+	}
+
+	// Burst
+	Rest();
+	uint32_t start = micros();
+	Send(stream);
+	RunUntilReplies(linesReceived + commands);
+	unsigned long burstTime = micros() - start;
+
+	// Paced
+	Rest();
+	unsigned long replyBytes = HostEthernetBytesSent();
+	unsigned long lcdBytes = LcdBytes();
+	unsigned long writesCommitted = motor->GetCommittedWrites();
+	unsigned long writesSkipped = motor->GetSkippedWrites();
+	for (unsigned int i = 0; i < commands; i++)
+	{
+		uint32_t sent = micros();
+		uint32_t lastMotorWrite = LastMotorWrite();
+
+		Send(stream.substr(i, 1));
+		RunUntilReplies(linesReceived + 1);
+		dispatch.push_back(HostEthernetLastSendMicros() - sent);
+		if (LastMotorWrite() != lastMotorWrite)
+		{
+			motorWrite.push_back(LastMotorWrite() - sent);
+		}
+
+		while (micros() - sent < BENCH_PACE) Pass();
+	}
+	RunFor(BENCH_SETTLE);
+	replyBytes = HostEthernetBytesSent() - replyBytes;
+	lcdBytes = LcdBytes() - lcdBytes;
+	writesCommitted = motor->GetCommittedWrites() - writesCommitted;
+	writesSkipped = motor->GetSkippedWrites() - writesSkipped;
+
+	printf("%-16s %8.0f", scenario.name, commands * 1000000.0 / burstTime);
+	PrintPercentiles(dispatch);
+	PrintPercentiles(motorWrite);
+	printf(" %6.1f %6.1f", (double) replyBytes / commands, (double) lcdBytes / commands);
+	printf(" %6.2f %6.2f\n", (double) writesCommitted / commands, (double) writesSkipped / commands);
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int commands = BENCH_DEFAULT_COMMANDS;
+	int option;
+
+	while ((option = getopt(argc, argv, "n:")) != -1)
+	{
+		switch (option)
+		{
+			case 'n':
+				commands = (unsigned int) strtoul(optarg, NULL, 10);
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-n commands]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (commands == 0) commands = BENCH_DEFAULT_COMMANDS;
+
+	HostClockSetVirtual(true);
+	HostEthernetSetListening(false);
+	setup();
+	client = HostEthernetConnect();
+	if (client < 0)
+	{
+		perror("sarc-bench: connect");
+		return 1;
+	}
+
+	#if defined(USE_LCD) && defined(LCD_IS_SERIAL)
+		const char* lcd = "serial";
+	#elif defined(USE_LCD)
+		const char* lcd = "parallel";
+	#else
+		const char* lcd = "none";
+	#endif
+	printf("SARC command benchmark: LCD %s, %u commands per stream, virtual clock\n", lcd, commands);
+	printf("%-16s %8s %23s %23s %13s %13s\n", "", "burst", "reply latency (us)", "motor latency (us)", "bytes/command", "writes/cmd");
+	printf("%-16s %8s %7s %7s %7s %7s %7s %7s %6s %6s %6s %6s\n",
+		"stream", "cmds/s", "p50", "p99", "max", "p50", "p99", "max", "reply", "LCD", "made", "skip");
+
+	scheduler.ResetStats();
+	for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+	{
+		RunScenario(scenarios[i], commands);
+	}
+
+	printf("\n%-16s %8s %7s %7s %7s\n", "task", "runs", "max", "late", "over");
+	for (uint8_t i = 0; i < scheduler.GetTaskCount(); i++)
+	{
+		const SARC::TaskStats& stats = scheduler.GetStats(i);
+		printf("%-16s %8lu %7lu %7lu %7u\n", scheduler.GetName(i), stats.runs, stats.maxDuration, stats.maxLateness, stats.overruns);
+	}
+	return 0;
+}
+
+#endif // SARC_HOST
@@ -0,0 +1,406 @@
+/*
+ * HostDevices.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host versions of the serial port, Servo, AF_DCMotor and LiquidCrystal.
+ *  They only record what they were told. See HostHal.h.
+ */
+
+#ifdef SARC_HOST
+
+#include <stdio.h>
+#include "Arduino.h"
+#include "Servo.h"
+#include "AFMotor.h"
+#include "LiquidCrystal.h"
+#include "HostHal.h"
+
+/************ LCD screen ************/
+
+/*
+ * Both kinds of LCD address the HD44780's display RAM the same way: row 0
+ * starts at 0, row 1 at 64, row 2 at 20 and row 3 at 84. Row 0 runs on into
+ * row 2 and row 1 into row 3, which is why the cursor "wraps" to an odd row.
+ */
+static const uint8_t rowAddress[HOST_LCD_ROWS] = { 0, 64, 20, 84 };
+
+static HostScreen screen;
+static uint8_t screenAddress = 0;
+
+static void ScreenReset(uint8_t rows, uint8_t columns)
+{
+	memset(screen.cells, ' ', sizeof(screen.cells));
+	screen.rows = rows <= HOST_LCD_ROWS ? rows : HOST_LCD_ROWS;
+	screen.columns = columns <= HOST_LCD_COLUMNS ? columns : HOST_LCD_COLUMNS;
+	screen.row = 0;
+	screen.column = 0;
+	screen.on = true;
+	screen.changed = true;
+	screenAddress = 0;
+}
+
+static void ScreenSetAddress(uint8_t address)
+{
+	screenAddress = address & 0x7F;
+}
+
+static void ScreenWrite(uint8_t c)
+{
+	for (uint8_t row = 0; row < HOST_LCD_ROWS; row++)
+	{
+		if (screenAddress >= rowAddress[row] && screenAddress < rowAddress[row] + HOST_LCD_COLUMNS)
+		{
+			screen.cells[row][screenAddress - rowAddress[row]] = (char) c;
+			screen.changed = true;
+		}
+	}
+	screenAddress = (screenAddress + 1) & 0x7F;
+}
+
+static void ScreenClear(void)
+{
+	memset(screen.cells, ' ', sizeof(screen.cells));
+	screen.changed = true;
+	screenAddress = 0;
+}
+
+const HostScreen& HostLcdScreen(void)
+{
+	// The serial LCD has no begin(), so start out as one.
+	if (screen.rows == 0) ScreenReset(4, 20);
+	return screen;
+}
+
+void HostLcdPrint(FILE* file)
+{
+	HostLcdScreen();
+
+	fputc('+', file);
+	for (uint8_t col = 0; col < screen.columns; col++) fputc('-', file);
+	fputs("+\n", file);
+	for (uint8_t row = 0; row < screen.rows; row++)
+	{
+		fprintf(file, "|%.*s|\n", screen.columns, screen.cells[row]);
+	}
+	fputc('+', file);
+	for (uint8_t col = 0; col < screen.columns; col++) fputc('-', file);
+	fputs("+\n", file);
+	fflush(file);
+	screen.changed = false;
+}
+
+/************ Serial ************/
+
+#define HOST_SERIAL_RX_SIZE	256
+
+HardwareSerial Serial;
+
+static uint8_t serialRx[HOST_SERIAL_RX_SIZE];
+static size_t serialRxHead = 0;
+static size_t serialRxCount = 0;
+static unsigned long serialBytesWritten = 0;
+static unsigned long serialBaud = 9600;
+static unsigned long serialMicrosPerByte = 10000000UL / 9600;
+static unsigned long serialTxQueued = 0;		// Bytes in the TX buffer, as of serialTxTime
+static uint32_t serialTxTime = 0;
+#ifdef LCD_IS_SERIAL
+static uint8_t serialLcdState = 0;		// 0 = text, 1 = after 0xFE, 2 = waiting for position
+#endif
+
+void HostSerialInject(const uint8_t* data, size_t length)
+{
+	while (length-- && serialRxCount < HOST_SERIAL_RX_SIZE)
+	{
+		serialRx[(serialRxHead + serialRxCount++) % HOST_SERIAL_RX_SIZE] = *data++;
+	}
+}
+
+unsigned long HostSerialBytesWritten(void)
+{
+	return serialBytesWritten;
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+	if (baud == 0) return;
+	serialBaud = baud;
+	serialMicrosPerByte = 10000000UL / baud;	// Start + 8 data + stop bits
+}
+
+unsigned long HostSerialBaud(void)
+{
+	return serialBaud;
+}
+void HardwareSerial::end(void) {}
+void HardwareSerial::flush(void) {}
+
+int HardwareSerial::available(void)
+{
+	#ifdef USE_XBEE_API
+		HostXBeePoll();
+	#endif
+	return (int) serialRxCount;
+}
+
+int HardwareSerial::peek(void)
+{
+	return serialRxCount ? serialRx[serialRxHead] : -1;
+}
+
+int HardwareSerial::read(void)
+{
+	if (serialRxCount == 0) return -1;
+	uint8_t c = serialRx[serialRxHead];
+	serialRxHead = (serialRxHead + 1) % HOST_SERIAL_RX_SIZE;
+	serialRxCount--;
+	return c;
+}
+
+/*
+ * With LCD_IS_SERIAL, the serial port is the LCD, so its commands (0xFE
+ * followed by a command byte) are decoded into the screen.
+ */
+size_t HardwareSerial::write(uint8_t c)
+{
+	serialBytesWritten++;
+
+	// Model the TX buffer on the virtual clock: it drains at the baud rate,
+	// and a write to a full buffer waits for a byte to go out.
+	if (HostClockIsVirtual())
+	{
+		unsigned long sent = (micros() - serialTxTime) / serialMicrosPerByte;
+		if (sent >= serialTxQueued)
+		{
+			serialTxQueued = 0;
+			serialTxTime = micros();
+		}
+		else
+		{
+			serialTxQueued -= sent;
+			serialTxTime += sent * serialMicrosPerByte;
+		}
+
+		if (serialTxQueued >= HOST_SERIAL_TX_BUFFER)
+		{
+			HostClockAdvance((uint32_t) (serialTxTime + serialMicrosPerByte - micros()));
+			serialTxQueued--;
+			serialTxTime += serialMicrosPerByte;
+		}
+		serialTxQueued++;
+	}
+
+	#if defined(USE_XBEE_API)
+		HostXBeeUartWrite(c);
+	#elif defined(USE_XBEE)
+		fputc(c, stdout);
+		fflush(stdout);
+	#endif
+
+	#ifdef LCD_IS_SERIAL
+		HostLcdScreen();
+		screen.bytes++;
+		switch (serialLcdState)
+		{
+			case 1:
+				serialLcdState = 0;
+				if (c == 0x45) serialLcdState = 2;
+				else if (c == 0x51) ScreenClear();
+				else if (c == 0x46) ScreenSetAddress(0);
+				else if (c == 0x41) screen.on = true;
+				else if (c == 0x42) screen.on = false;
+				break;
+			case 2:
+				serialLcdState = 0;
+				ScreenSetAddress(c);
+				break;
+			default:
+				if (c == 0xFE) serialLcdState = 1;
+				else ScreenWrite(c);
+				break;
+		}
+	#endif
+
+	return 1;
+}
+
+/************ LiquidCrystal ************/
+
+LiquidCrystal::LiquidCrystal(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t) {}
+LiquidCrystal::LiquidCrystal(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t) {}
+LiquidCrystal::LiquidCrystal(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t,
+							 uint8_t, uint8_t, uint8_t, uint8_t) {}
+
+void LiquidCrystal::begin(uint8_t cols, uint8_t rows)
+{
+	ScreenReset(rows, cols);
+}
+
+void LiquidCrystal::clear(void)
+{
+	HostClockAdvance(HOST_COST_LCD_CLEAR);
+	screen.bytes++;
+	ScreenClear();
+}
+
+void LiquidCrystal::home(void)
+{
+	HostClockAdvance(HOST_COST_LCD_CLEAR);
+	screen.bytes++;
+	ScreenSetAddress(0);
+}
+
+void LiquidCrystal::display(void)
+{
+	HostClockAdvance(HOST_COST_LCD_BYTE);
+	screen.bytes++;
+	screen.on = true;
+}
+
+void LiquidCrystal::noDisplay(void)
+{
+	HostClockAdvance(HOST_COST_LCD_BYTE);
+	screen.bytes++;
+	screen.on = false;
+}
+
+void LiquidCrystal::setCursor(uint8_t col, uint8_t row)
+{
+	HostClockAdvance(HOST_COST_LCD_BYTE);
+	screen.bytes++;
+	if (row >= HOST_LCD_ROWS) row = HOST_LCD_ROWS - 1;
+	ScreenSetAddress(rowAddress[row] + col);
+}
+
+size_t LiquidCrystal::write(uint8_t c)
+{
+	HostClockAdvance(HOST_COST_LCD_BYTE);
+	screen.bytes++;
+	ScreenWrite(c);
+	return 1;
+}
+
+/************ Servo ************/
+
+static Servo* servos[HOST_MAX_SERVOS];
+
+Servo::Servo()
+{
+	_pin = -1;
+	_min = MIN_PULSE_WIDTH;
+	_max = MAX_PULSE_WIDTH;
+	_microseconds = DEFAULT_PULSE_WIDTH;
+	_writes = 0;
+	_lastWrite = 0;
+}
+
+uint8_t Servo::attach(int pin)
+{
+	return attach(pin, MIN_PULSE_WIDTH, MAX_PULSE_WIDTH);
+}
+
+uint8_t Servo::attach(int pin, int min, int max)
+{
+	_pin = pin;
+	_min = min;
+	_max = max;
+	for (uint8_t i = 0; i < HOST_MAX_SERVOS; i++)
+	{
+		if (servos[i] == NULL || servos[i] == this)
+		{
+			servos[i] = this;
+			return i;
+		}
+	}
+	return 0xFF;
+}
+
+void Servo::detach(void)
+{
+	for (uint8_t i = 0; i < HOST_MAX_SERVOS; i++)
+	{
+		if (servos[i] == this) servos[i] = NULL;
+	}
+	_pin = -1;
+}
+
+bool Servo::attached(void)
+{
+	return _pin >= 0;
+}
+
+// Like the Arduino library, values below MIN_PULSE_WIDTH are angles.
+void Servo::write(int value)
+{
+	if (value < MIN_PULSE_WIDTH)
+	{
+		if (value < 0) value = 0;
+		if (value > 180) value = 180;
+		value = map(value, 0, 180, _min, _max);
+	}
+	writeMicroseconds(value);
+}
+
+// Like the Arduino library, the pulse width is limited to the attach() range.
+void Servo::writeMicroseconds(int value)
+{
+	if (value < _min) value = _min;
+	if (value > _max) value = _max;
+	HostClockAdvance(HOST_COST_SERVO_WRITE);
+	_microseconds = value;
+	_writes++;
+	_lastWrite = micros();
+}
+
+int Servo::read(void)
+{
+	return map(_microseconds + 1, _min, _max, 0, 180);
+}
+
+int Servo::readMicroseconds(void)
+{
+	return _microseconds;
+}
+
+Servo* HostFindServo(int pin)
+{
+	for (uint8_t i = 0; i < HOST_MAX_SERVOS; i++)
+	{
+		if (servos[i] != NULL && servos[i]->pin() == pin) return servos[i];
+	}
+	return NULL;
+}
+
+/************ AF_DCMotor ************/
+
+static AF_DCMotor* dcMotors[4];
+
+AF_DCMotor::AF_DCMotor(uint8_t motorNumber, uint8_t)
+{
+	_number = motorNumber;
+	_speed = 0;
+	_command = RELEASE;
+	_lastWrite = 0;
+	if (motorNumber >= 1 && motorNumber <= 4) dcMotors[motorNumber - 1] = this;
+}
+
+void AF_DCMotor::run(uint8_t command)
+{
+	_command = command;
+	_lastWrite = micros();
+}
+
+void AF_DCMotor::setSpeed(uint8_t speed)
+{
+	HostClockAdvance(HOST_COST_DC_SPEED);
+	_speed = speed;
+	_lastWrite = micros();
+}
+
+AF_DCMotor* HostFindDCMotor(uint8_t motorNumber)
+{
+	if (motorNumber < 1 || motorNumber > 4) return NULL;
+	return dcMotors[motorNumber - 1];
+}
+
+#endif // SARC_HOST
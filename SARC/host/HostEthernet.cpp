@@ -0,0 +1,418 @@
+/*
+ * HostEthernet.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host version of the Ethernet library, on TCP sockets. See Ethernet.h.
+ */
+
+#ifdef SARC_HOST
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include "Ethernet.h"
+#include "EthernetUdp.h"
+#include "HostHal.h"
+
+#define NO_SOCKET	HOST_MAX_SOCKETS
+
+// File descriptor of each "W5100 socket", or -1. Slot 0 is never used, so
+// zero-initialized storage doesn't look like open sockets.
+static int sockets[HOST_MAX_SOCKETS + 1] = { -1, -1, -1, -1, -1 };
+static uint16_t portOverride = 0;
+static bool listening = true;
+static unsigned long bytesSent = 0;
+static uint32_t lastSendMicros = 0;
+static uint16_t udpBoundPort = 0;
+
+EthernetClass Ethernet;
+
+static void CloseSocket(uint8_t socket)
+{
+	if (socket < HOST_MAX_SOCKETS && sockets[socket] >= 0)
+	{
+		close(sockets[socket]);
+		sockets[socket] = -1;
+	}
+}
+
+void HostEthernetSetPort(uint16_t port)
+{
+	portOverride = port;
+}
+
+void HostEthernetSetListening(bool isListening)
+{
+	listening = isListening;
+}
+
+unsigned long HostEthernetBytesSent(void)
+{
+	return bytesSent;
+}
+
+uint32_t HostEthernetLastSendMicros(void)
+{
+	return lastSendMicros;
+}
+
+uint16_t HostEthernetUdpPort(void)
+{
+	return udpBoundPort;
+}
+
+/*
+ * A socket pair takes the place of a TCP connection. The robot's end goes in
+ * a free socket, as if accepted by the server.
+ */
+int HostEthernetConnect(void)
+{
+	int pair[2];
+	uint8_t socket = 0;
+
+	while (socket < HOST_MAX_SOCKETS && sockets[socket] >= 0) socket++;
+	if (socket == HOST_MAX_SOCKETS) return -1;
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) < 0) return -1;
+
+	fcntl(pair[0], F_SETFL, O_NONBLOCK);
+	sockets[socket] = pair[0];
+	return pair[1];
+}
+
+// The host's own network configuration is used.
+void EthernetClass::begin(uint8_t*, uint8_t*, uint8_t*, uint8_t*)
+{
+}
+
+/************ EthernetServer ************/
+
+EthernetServer::EthernetServer(uint16_t port)
+{
+	_port = port;
+	_listener = -1;
+}
+
+void EthernetServer::begin(void)
+{
+	uint16_t port = portOverride != 0 ? portOverride : _port;
+	struct sockaddr_in address;
+	int yes = 1;
+
+	if (!listening) return;
+	_listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (_listener < 0)
+	{
+		perror("EthernetServer: socket");
+		return;
+	}
+	setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+	if (bind(_listener, (struct sockaddr*) &address, sizeof(address)) < 0
+		|| listen(_listener, HOST_MAX_SOCKETS) < 0)
+	{
+		perror("EthernetServer: bind/listen");
+		close(_listener);
+		_listener = -1;
+		return;
+	}
+	fcntl(_listener, F_SETFL, O_NONBLOCK);
+	fprintf(stderr, "EthernetServer: listening on port %u\n", port);
+}
+
+/*
+ * Takes every pending connection that fits in a free socket. Like the
+ * W5100, connections beyond HOST_MAX_SOCKETS are refused.
+ */
+void EthernetServer::accept(void)
+{
+	if (_listener < 0) return;
+
+	int fd;
+	while ((fd = ::accept(_listener, NULL, NULL)) >= 0)
+	{
+		uint8_t socket = 0;
+		while (socket < HOST_MAX_SOCKETS && sockets[socket] >= 0) socket++;
+		if (socket == HOST_MAX_SOCKETS)
+		{
+			close(fd);
+			continue;
+		}
+
+		int yes = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+		fcntl(fd, F_SETFL, O_NONBLOCK);
+		sockets[socket] = fd;
+	}
+}
+
+EthernetClient EthernetServer::available(void)
+{
+	HostClockAdvance(HOST_COST_ETHERNET_POLL);
+	accept();
+	for (uint8_t socket = 0; socket < HOST_MAX_SOCKETS; socket++)
+	{
+		EthernetClient client(socket);
+		if (client && client.available() > 0)
+			return client;
+	}
+	return EthernetClient();
+}
+
+/************ EthernetClient ************/
+
+EthernetClient::EthernetClient()
+{
+	_socket = NO_SOCKET;
+}
+
+EthernetClient::EthernetClient(uint8_t socket)
+{
+	_socket = socket;
+}
+
+EthernetClient::operator bool(void)
+{
+	return _socket < HOST_MAX_SOCKETS && sockets[_socket] >= 0;
+}
+
+/*
+ * Still connected while there is unread data, even if the other end has
+ * closed, as on the Arduino. A socket whose other end has closed is freed.
+ */
+uint8_t EthernetClient::connected(void)
+{
+	if (!*this) return 0;
+	if (available() > 0) return 1;
+
+	char c;
+	ssize_t n = recv(sockets[_socket], &c, 1, MSG_PEEK | MSG_DONTWAIT);
+	if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 1;
+
+	CloseSocket(_socket);
+	return 0;
+}
+
+int EthernetClient::available(void)
+{
+	int count = 0;
+	HostClockAdvance(HOST_COST_ETHERNET_POLL);
+	if (!*this || ioctl(sockets[_socket], FIONREAD, &count) < 0) return 0;
+	return count;
+}
+
+int EthernetClient::read(void)
+{
+	uint8_t c;
+	HostClockAdvance(HOST_COST_ETHERNET_READ);
+	if (!*this || recv(sockets[_socket], &c, 1, MSG_DONTWAIT) != 1) return -1;
+	return c;
+}
+
+int EthernetClient::read(uint8_t* buffer, size_t size)
+{
+	if (!*this) return -1;
+	ssize_t n = recv(sockets[_socket], buffer, size, MSG_DONTWAIT);
+	if (n <= 0) return -1;
+	HostClockAdvance(HOST_COST_ETHERNET_READ + n * HOST_COST_ETHERNET_BYTE);
+	return (int) n;
+}
+
+int EthernetClient::peek(void)
+{
+	uint8_t c;
+	if (!*this || recv(sockets[_socket], &c, 1, MSG_PEEK | MSG_DONTWAIT) != 1) return -1;
+	return c;
+}
+
+void EthernetClient::flush(void)
+{
+	while (read() >= 0) {}
+}
+
+void EthernetClient::stop(void)
+{
+	CloseSocket(_socket);
+	_socket = NO_SOCKET;
+}
+
+size_t EthernetClient::write(uint8_t c)
+{
+	return write(&c, 1);
+}
+
+size_t EthernetClient::write(const uint8_t* buffer, size_t size)
+{
+	if (!*this) return 0;
+	HostClockAdvance(HOST_COST_ETHERNET_SEND + size * HOST_COST_ETHERNET_BYTE);
+	ssize_t n = send(sockets[_socket], buffer, size, MSG_NOSIGNAL);
+	if (n <= 0) return 0;
+	bytesSent += n;
+	lastSendMicros = micros();
+	return (size_t) n;
+}
+
+/************ EthernetUDP ************/
+
+static uint8_t udpRx[HOST_UDP_MAX_PACKET];
+static uint8_t udpTx[HOST_UDP_MAX_PACKET];
+
+EthernetUDP::EthernetUDP()
+{
+	_socket = -1;
+	_rxLength = 0;
+	_rxPosition = 0;
+	_remotePort = 0;
+	_txLength = 0;
+	_txPort = 0;
+}
+
+uint8_t EthernetUDP::begin(uint16_t port)
+{
+	struct sockaddr_in address;
+	socklen_t addressLength = sizeof(address);
+
+	if (portOverride != 0) port = portOverride;
+
+	_socket = socket(AF_INET, SOCK_DGRAM, 0);
+	if (_socket < 0)
+	{
+		perror("EthernetUDP: socket");
+		return 0;
+	}
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	if (listening)
+	{
+		address.sin_addr.s_addr = htonl(INADDR_ANY);
+		address.sin_port = htons(port);
+	}
+	else
+	{
+		// Only for this process; any free port.
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		address.sin_port = 0;
+	}
+	if (bind(_socket, (struct sockaddr*) &address, sizeof(address)) < 0
+		|| getsockname(_socket, (struct sockaddr*) &address, &addressLength) < 0)
+	{
+		perror("EthernetUDP: bind");
+		close(_socket);
+		_socket = -1;
+		return 0;
+	}
+	fcntl(_socket, F_SETFL, O_NONBLOCK);
+	udpBoundPort = ntohs(address.sin_port);
+	if (listening) fprintf(stderr, "EthernetUDP: listening on port %u\n", udpBoundPort);
+	return 1;
+}
+
+void EthernetUDP::stop(void)
+{
+	if (_socket >= 0) close(_socket);
+	_socket = -1;
+}
+
+int EthernetUDP::parsePacket(void)
+{
+	struct sockaddr_in address;
+	socklen_t addressLength = sizeof(address);
+
+	_rxLength = 0;
+	_rxPosition = 0;
+	if (_socket < 0) return 0;
+
+	HostClockAdvance(HOST_COST_ETHERNET_POLL);
+	ssize_t n = recvfrom(_socket, udpRx, sizeof(udpRx), MSG_DONTWAIT, (struct sockaddr*) &address, &addressLength);
+	if (n <= 0) return 0;
+
+	_rxLength = (size_t) n;
+	_remoteIP = IPAddress((uint32_t) address.sin_addr.s_addr);
+	_remotePort = ntohs(address.sin_port);
+	return (int) n;
+}
+
+int EthernetUDP::available(void)
+{
+	return (int) (_rxLength - _rxPosition);
+}
+
+int EthernetUDP::read(void)
+{
+	uint8_t c;
+	return read(&c, 1) == 1 ? c : -1;
+}
+
+int EthernetUDP::read(uint8_t* buffer, size_t size)
+{
+	size_t count = _rxLength - _rxPosition;
+	if (count == 0) return -1;
+	if (count > size) count = size;
+
+	HostClockAdvance(HOST_COST_ETHERNET_READ + count * HOST_COST_ETHERNET_BYTE);
+	memcpy(buffer, udpRx + _rxPosition, count);
+	_rxPosition += count;
+	return (int) count;
+}
+
+IPAddress EthernetUDP::remoteIP(void)
+{
+	return _remoteIP;
+}
+
+uint16_t EthernetUDP::remotePort(void)
+{
+	return _remotePort;
+}
+
+int EthernetUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+	_txIP = ip;
+	_txPort = port;
+	_txLength = 0;
+	return 1;
+}
+
+size_t EthernetUDP::write(uint8_t c)
+{
+	return write(&c, 1);
+}
+
+size_t EthernetUDP::write(const uint8_t* buffer, size_t size)
+{
+	if (size > sizeof(udpTx) - _txLength) size = sizeof(udpTx) - _txLength;
+	memcpy(udpTx + _txLength, buffer, size);
+	_txLength += size;
+	return size;
+}
+
+int EthernetUDP::endPacket(void)
+{
+	struct sockaddr_in address;
+
+	if (_socket < 0) return 0;
+	HostClockAdvance(HOST_COST_ETHERNET_SEND + _txLength * HOST_COST_ETHERNET_BYTE);
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = (uint32_t) _txIP;
+	address.sin_port = htons(_txPort);
+	ssize_t n = sendto(_socket, udpTx, _txLength, 0, (struct sockaddr*) &address, sizeof(address));
+	_txLength = 0;
+	if (n <= 0) return 0;
+	bytesSent += n;
+	lastSendMicros = micros();
+	return 1;
+}
+
+#endif // SARC_HOST
@@ -0,0 +1,119 @@
+/*
+ * HostHal.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host (Linux) hardware abstraction layer. The headers in this folder stand
+ *  in for the Arduino core and the libraries SARC uses, so the SARC sources
+ *  build unmodified with g++ (see the Makefile). This file has the controls
+ *  that only exist on the host: the clock, and what the "hardware" was told.
+ *
+ *  Clock - real time by default. In virtual mode, time only moves when
+ *  HostClockAdvance() (or delay()) is called, so runs are repeatable. The
+ *  stand-in devices then also advance the clock by what the real device would
+ *  take (the HOST_COST_* estimates below, for a 16 MHz AVR), and a write to a
+ *  full serial TX buffer waits for it to drain at the baud rate. The SARC
+ *  code itself takes no virtual time.
+ */
+
+#ifndef HOSTHAL_H_
+#define HOSTHAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/************ Costs (microseconds, virtual clock only) ************/
+#define HOST_COST_DIGITAL_WRITE		5		// digitalWrite()
+#define HOST_COST_SERVO_WRITE		3		// Servo::writeMicroseconds()
+#define HOST_COST_DC_SPEED			3		// AF_DCMotor::setSpeed()
+#define HOST_COST_ETHERNET_POLL		30		// W5100 status/size read over SPI
+#define HOST_COST_ETHERNET_READ		30		// Per read, including the pointer update, plus per byte below
+#define HOST_COST_ETHERNET_SEND		100		// Per send, plus per byte below
+#define HOST_COST_ETHERNET_BYTE		2
+#define HOST_COST_LCD_BYTE			220		// LiquidCrystal, 4 bit mode
+#define HOST_COST_LCD_CLEAR			2000	// LiquidCrystal clear() and home()
+#define HOST_SERIAL_TX_BUFFER		64		// HardwareSerial, Arduino 1.0
+
+/************ Memory ************/
+// See MemoryDiag.h. Bytes of stack painted by PaintStack() that stand in for
+// the free RAM, and the heap in use (from operator new and delete).
+#define HOST_STACK_PAINT			16384
+unsigned long HostHeapUsed(void);
+
+/************ Clock ************/
+void HostClockSetVirtual(bool isVirtual);
+bool HostClockIsVirtual(void);
+void HostClockAdvance(unsigned long microseconds);
+
+/************ Pins ************/
+uint8_t HostPinState(uint8_t pin);
+// The byte last latched into the motor shield's 74HC595.
+uint8_t HostAFLatch(void);
+uint32_t HostAFLatchMicros(void);
+
+/************ Serial ************/
+// Bytes for Serial.read().
+void HostSerialInject(const uint8_t* data, size_t length);
+// Total bytes written to Serial.
+unsigned long HostSerialBytesWritten(void);
+// The rate set by the last Serial.begin().
+unsigned long HostSerialBaud(void);
+
+/************ XBee ************/
+// With USE_XBEE_API, the serial port is connected to a fake radio in escaped
+// API mode (HostXBee.cpp), which starts at 9600 baud and changes when told
+// to with ATBD. Bytes sent at the wrong rate don't get through. The far end
+// of its radio link is a pseudo-terminal: what's written there arrives as a
+// packet from HOST_XBEE_REMOTE, and packets sent by the robot come out
+// there. Without it, nothing is delivered.
+#define HOST_XBEE_REMOTE	0x0002
+// @return: The name of the pseudo-terminal (e.g. /dev/pts/3), or NULL.
+const char* HostXBeeOpen(void);
+// Percentage of packets lost each way. Lost packets from the robot are
+// reported as XBEE_TX_NO_ACK.
+void HostXBeeSetLoss(unsigned int percent);
+// One byte in this many from the radio to the robot gets a bit flipped.
+// 0 = none.
+void HostXBeeSetNoise(unsigned long oneIn);
+// The radio's UART rate.
+unsigned long HostXBeeBaud(void);
+// For the serial port stand-in.
+void HostXBeeUartWrite(uint8_t c);
+void HostXBeePoll(void);
+
+/************ Ethernet ************/
+void HostEthernetSetPort(uint16_t port);
+// false = the server doesn't listen at all; only HostEthernetConnect() works.
+// EthernetUDP then only takes datagrams from this host, on any free port.
+void HostEthernetSetListening(bool listening);
+// The port EthernetUDP is bound to, or 0.
+uint16_t HostEthernetUdpPort(void);
+// Connects a client from inside this process, without the network.
+// @return: The client's end of the connection (a file descriptor), or -1.
+int HostEthernetConnect(void);
+// Total bytes sent to clients, and when the last of them were sent.
+unsigned long HostEthernetBytesSent(void);
+uint32_t HostEthernetLastSendMicros(void);
+
+/************ LCD ************/
+#define HOST_LCD_ROWS		4
+#define HOST_LCD_COLUMNS	20
+
+// What a serial LCD or a LiquidCrystal would show.
+struct HostScreen
+{
+	char cells[HOST_LCD_ROWS][HOST_LCD_COLUMNS];
+	uint8_t rows;
+	uint8_t columns;
+	uint8_t row;			// Cursor
+	uint8_t column;
+	bool on;
+	bool changed;			// Set on every change. Cleared by HostLcdPrint().
+	unsigned long bytes;	// Everything sent to the LCD, commands included
+};
+
+const HostScreen& HostLcdScreen(void);
+void HostLcdPrint(FILE* file);
+
+#endif /* HOSTHAL_H_ */
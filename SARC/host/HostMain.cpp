@@ -0,0 +1,104 @@
+/*
+ * HostMain.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  main() for the host build: runs setup(), then loop() forever, like the
+ *  Arduino core does.
+ *
+ *  Usage: sarc-host [-p port] [-l] [-s microseconds] [-x percent] [-e bytes]
+ *  	-p	Port the Ethernet server listens on. Default HOST_DEFAULT_PORT,
+ *  		so telnet's port 23 doesn't need root.
+ *  	-l	Print the LCD whenever it changes.
+ *  	-s	Sleep between passes of loop(), so an idle robot doesn't use a
+ *  		whole CPU. Default HOST_DEFAULT_SLEEP. 0 = don't sleep.
+ *  	-x	Percentage of XBee packets lost (USE_XBEE_API).
+ *  	-e	Flip a bit in one byte in this many from the XBee (USE_XBEE_API).
+ *
+ *  With USE_XBEE, stdin and stdout are the serial port. With USE_XBEE_API,
+ *  the serial port goes to a fake radio instead, and the client talks to the
+ *  pseudo-terminal named at startup (see HostHal.h).
+ */
+
+#ifdef SARC_HOST
+
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "SARC.h"
+#include "HostHal.h"
+
+#define HOST_DEFAULT_PORT	2323
+#define HOST_DEFAULT_SLEEP	100		// Microseconds
+
+#if defined(USE_XBEE) && !defined(USE_XBEE_API)
+// Moves whatever is waiting on stdin to the serial port.
+static void ReadStdin(void)
+{
+	struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+	uint8_t buffer[64];
+
+	if (poll(&input, 1, 0) > 0 && (input.revents & POLLIN))
+	{
+		ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+		if (n > 0) HostSerialInject(buffer, (size_t) n);
+	}
+}
+#endif // USE_XBEE && !USE_XBEE_API
+
+int main(int argc, char** argv)
+{
+	bool showLcd = false;
+	unsigned long sleepMicros = HOST_DEFAULT_SLEEP;
+	int option;
+
+	HostEthernetSetPort(HOST_DEFAULT_PORT);
+	while ((option = getopt(argc, argv, "p:ls:x:e:")) != -1)
+	{
+		switch (option)
+		{
+			case 'p':
+				HostEthernetSetPort((uint16_t) atoi(optarg));
+				break;
+			case 'l':
+				showLcd = true;
+				break;
+			case 's':
+				sleepMicros = strtoul(optarg, NULL, 10);
+				break;
+			case 'x':
+				HostXBeeSetLoss((unsigned int) atoi(optarg));
+				break;
+			case 'e':
+				HostXBeeSetNoise(strtoul(optarg, NULL, 10));
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-p port] [-l] [-s microseconds] [-x percent] [-e bytes]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	#ifdef USE_XBEE_API
+		const char* radio = HostXBeeOpen();
+		if (radio == NULL) return 1;
+		fprintf(stderr, "XBee: the client end is %s\n", radio);
+	#endif
+
+	setup();
+	for (;;)
+	{
+		#if defined(USE_XBEE) && !defined(USE_XBEE_API)
+			ReadStdin();
+		#endif
+
+		loop();
+
+		if (showLcd && HostLcdScreen().changed)
+			HostLcdPrint(stderr);
+		if (sleepMicros != 0)
+			usleep(sleepMicros);
+	}
+	return 0;
+}
+
+#endif // SARC_HOST
@@ -0,0 +1,53 @@
+/*
+ * HostMemory.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Counting allocator for the host build: replaces the global operator new
+ *  and delete so MemoryDiag can report how much heap is in use, like it
+ *  does from the AVR's malloc() break. See HostHal.h.
+ */
+
+#ifdef SARC_HOST
+
+#include <new>
+#include <stdlib.h>
+#include "HostHal.h"
+
+// Each block starts with its size, padded to keep the caller's alignment.
+union BlockHeader
+{
+	size_t size;
+	long double alignment;
+};
+
+static unsigned long heapUsed = 0;
+
+unsigned long HostHeapUsed(void)
+{
+	return heapUsed;
+}
+
+static void* Allocate(size_t size)
+{
+	BlockHeader* block = (BlockHeader*) malloc(sizeof(BlockHeader) + size);
+	if (!block) throw std::bad_alloc();
+	block->size = size;
+	heapUsed += size;
+	return block + 1;
+}
+
+static void Free(void* pointer)
+{
+	if (!pointer) return;
+	BlockHeader* block = (BlockHeader*) pointer - 1;
+	heapUsed -= block->size;
+	free(block);
+}
+
+void* operator new(size_t size) throw (std::bad_alloc) { return Allocate(size); }
+void* operator new[](size_t size) throw (std::bad_alloc) { return Allocate(size); }
+void operator delete(void* pointer) throw () { Free(pointer); }
+void operator delete[](void* pointer) throw () { Free(pointer); }
+
+#endif // SARC_HOST
@@ -0,0 +1,214 @@
+/*
+ * HostXBee.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  A fake XBee radio in escaped API mode, on the far side of the serial port
+ *  stand-in (USE_XBEE_API). See HostHal.h. It understands what Connection
+ *  sends: AT commands (BD, AP) and transmit requests, and it makes up
+ *  receive packets from what is written to its pseudo-terminal.
+ */
+
+#ifdef SARC_HOST
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "XBee.h"
+#include "HostHal.h"
+
+#define HOST_XBEE_RSSI		40		// -40 dBm
+#define HOST_XBEE_AT_ERROR	1
+
+static SARC::XBeeFrameParser<XBEE_MAX_FRAME> uartParser;	// Frames from the Arduino
+static unsigned long radioBaud = 9600;
+static int ptyMaster = -1;
+static int ptySlave = -1;					// Kept open, so reads don't fail while nobody else has it open.
+static unsigned int lossPercent = 0;
+static unsigned long noiseOneIn = 0;
+
+static const unsigned long baudRates[] = { 1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200 };
+
+// Bytes from the radio to the Arduino. They only get through at the right
+// rate, and may be hit by noise on the way.
+class RadioOutput : public Print
+{
+public:
+	virtual size_t write(uint8_t c)
+	{
+		if (HostSerialBaud() != radioBaud) return 1;
+		if (noiseOneIn != 0 && (unsigned long) rand() % noiseOneIn == 0) c ^= 1 << (rand() % 8);
+		HostSerialInject(&c, 1);
+		return 1;
+	}
+	using Print::write;
+};
+
+static RadioOutput radioOutput;
+
+static bool Lost(void)
+{
+	return lossPercent != 0 && (unsigned int) (rand() % 100) < lossPercent;
+}
+
+const char* HostXBeeOpen(void)
+{
+	struct termios settings;
+
+	ptyMaster = posix_openpt(O_RDWR | O_NOCTTY);
+	if (ptyMaster < 0 || grantpt(ptyMaster) < 0 || unlockpt(ptyMaster) < 0)
+	{
+		perror("HostXBee: pseudo-terminal");
+		return NULL;
+	}
+	const char* name = ptsname(ptyMaster);
+	ptySlave = open(name, O_RDWR | O_NOCTTY);
+	if (ptySlave >= 0 && tcgetattr(ptySlave, &settings) == 0)
+	{
+		cfmakeraw(&settings);
+		tcsetattr(ptySlave, TCSANOW, &settings);
+	}
+	fcntl(ptyMaster, F_SETFL, O_NONBLOCK);
+	return name;
+}
+
+void HostXBeeSetLoss(unsigned int percent)
+{
+	lossPercent = percent;
+}
+
+void HostXBeeSetNoise(unsigned long oneIn)
+{
+	noiseOneIn = oneIn;
+}
+
+unsigned long HostXBeeBaud(void)
+{
+	return radioBaud;
+}
+
+static void SendAtResponse(uint8_t id, const uint8_t* command, uint8_t status, const uint8_t* value, uint8_t length)
+{
+	SARC::XBeeFrameWriter writer(radioOutput);
+
+	writer.Begin(5 + length);
+	writer.Write(XBEE_API_AT_RESPONSE);
+	writer.Write(id);
+	writer.Write(command, 2);
+	writer.Write(status);
+	writer.Write(value, length);
+	writer.End();
+}
+
+static void HandleAtCommand(const uint8_t* frame, uint8_t length)
+{
+	uint8_t id = frame[1];
+	const uint8_t* command = frame + 2;
+	uint8_t value[4] = { 0, 0, 0, 0 };
+
+	if (command[0] == 'B' && command[1] == 'D')
+	{
+		if (length == 4)
+		{
+			for (uint8_t i = 0; i < 8; i++)
+			{
+				if (baudRates[i] == radioBaud) value[3] = i;
+			}
+			if (id != 0) SendAtResponse(id, command, XBEE_AT_OK, value, 4);
+		}
+		else if (frame[4] < 8)
+		{
+			// The reply still goes out at the old rate.
+			if (id != 0) SendAtResponse(id, command, XBEE_AT_OK, NULL, 0);
+			radioBaud = baudRates[frame[4]];
+			fprintf(stderr, "HostXBee: %lu baud\n", radioBaud);
+		}
+		else if (id != 0)
+		{
+			SendAtResponse(id, command, HOST_XBEE_AT_ERROR, NULL, 0);
+		}
+	}
+	else if (command[0] == 'A' && command[1] == 'P' && length == 4)
+	{
+		value[0] = 2;		// Escaped API mode
+		if (id != 0) SendAtResponse(id, command, XBEE_AT_OK, value, 1);
+	}
+	else if (id != 0)
+	{
+		SendAtResponse(id, command, HOST_XBEE_AT_ERROR, NULL, 0);
+	}
+}
+
+static void HandleTransmit(const uint8_t* frame, uint8_t length, uint8_t header)
+{
+	uint8_t status = XBEE_TX_SUCCESS;
+
+	// Nobody at the other end without the pseudo-terminal.
+	if (ptyMaster < 0 || Lost())
+	{
+		status = XBEE_TX_NO_ACK;
+	}
+	else if (length > header && write(ptyMaster, frame + header, length - header) < 0)
+	{
+		status = XBEE_TX_NO_ACK;
+	}
+
+	if (frame[1] != 0)
+	{
+		SARC::XBeeFrameWriter writer(radioOutput);
+		writer.Begin(3);
+		writer.Write(XBEE_API_TX_STATUS);
+		writer.Write(frame[1]);
+		writer.Write(status);
+		writer.End();
+	}
+}
+
+void HostXBeeUartWrite(uint8_t c)
+{
+	if (HostSerialBaud() != radioBaud) return;		// Framing errors
+	if (uartParser.Feed(c) != SARC::xbeeFrameReady) return;
+
+	const uint8_t* frame = uartParser.GetData();
+	uint8_t length = (uint8_t) uartParser.GetLength();
+	switch (frame[0])
+	{
+		case XBEE_API_AT_COMMAND:
+			if (length >= 4) HandleAtCommand(frame, length);
+			break;
+		case XBEE_API_TX_16:
+			if (length >= 5) HandleTransmit(frame, length, 1 + 1 + 2 + 1);
+			break;
+		case XBEE_API_TX_64:
+			if (length >= 11) HandleTransmit(frame, length, 1 + 1 + 8 + 1);
+			break;
+	}
+}
+
+/*
+ * Whatever has been written to the pseudo-terminal arrives as one packet
+ * from HOST_XBEE_REMOTE, so write a whole frame at a time to keep it together.
+ */
+void HostXBeePoll(void)
+{
+	uint8_t data[XBEE_MAX_PAYLOAD];
+
+	if (ptyMaster < 0) return;
+	ssize_t n = read(ptyMaster, data, sizeof(data));
+	if (n <= 0 || Lost()) return;
+
+	SARC::XBeeFrameWriter writer(radioOutput);
+	writer.Begin(1 + 2 + 2 + n);
+	writer.Write(XBEE_API_RX_16);
+	writer.Write((uint8_t) (HOST_XBEE_REMOTE >> 8));
+	writer.Write((uint8_t) HOST_XBEE_REMOTE);
+	writer.Write(HOST_XBEE_RSSI);
+	writer.Write(0);		// Options
+	writer.Write(data, (uint8_t) n);
+	writer.End();
+}
+
+#endif // SARC_HOST
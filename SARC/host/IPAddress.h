@@ -0,0 +1,42 @@
+/*
+ * IPAddress.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host stand-in for the Arduino core's IPAddress: four bytes in network
+ *  order, convertible to and from a uint32_t.
+ */
+
+#ifndef HOST_IPADDRESS_H_
+#define HOST_IPADDRESS_H_
+
+#include <stdint.h>
+#include <string.h>
+
+class IPAddress
+{
+public:
+	IPAddress() { memset(_address, 0, sizeof(_address)); }
+	IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+	{
+		_address[0] = a;
+		_address[1] = b;
+		_address[2] = c;
+		_address[3] = d;
+	}
+	IPAddress(uint32_t address) { memcpy(_address, &address, sizeof(_address)); }
+	IPAddress(const uint8_t* address) { memcpy(_address, address, sizeof(_address)); }
+
+	operator uint32_t() const
+	{
+		uint32_t address;
+		memcpy(&address, _address, sizeof(address));
+		return address;
+	}
+	uint8_t operator[](int index) const { return _address[index]; }
+
+private:
+	uint8_t _address[4];
+};
+
+#endif /* HOST_IPADDRESS_H_ */
@@ -0,0 +1,37 @@
+/*
+ * LiquidCrystal.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host stand-in for the LiquidCrystal library. Everything written ends up
+ *  in HostLcdScreen() (see HostHal.h).
+ */
+
+#ifndef HOST_LIQUIDCRYSTAL_H_
+#define HOST_LIQUIDCRYSTAL_H_
+
+#include <stdint.h>
+#include "Print.h"
+
+class LiquidCrystal : public Print
+{
+public:
+	LiquidCrystal(uint8_t rs, uint8_t enable,
+				  uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3);
+	LiquidCrystal(uint8_t rs, uint8_t rw, uint8_t enable,
+				  uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3);
+	LiquidCrystal(uint8_t rs, uint8_t enable,
+				  uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3,
+				  uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7);
+
+	void begin(uint8_t cols, uint8_t rows);
+	void clear(void);
+	void home(void);
+	void display(void);
+	void noDisplay(void);
+	void setCursor(uint8_t col, uint8_t row);
+	virtual size_t write(uint8_t c);
+	using Print::write;
+};
+
+#endif /* HOST_LIQUIDCRYSTAL_H_ */
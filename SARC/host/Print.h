@@ -0,0 +1,51 @@
+/*
+ * Print.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host stand-in for the Arduino Print class. println() ends lines with
+ *  "\r\n", as the Arduino does.
+ */
+
+#ifndef HOST_PRINT_H_
+#define HOST_PRINT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define DEC	10
+#define HEX	16
+#define OCT	8
+#define BIN	2
+
+class Print
+{
+public:
+	virtual ~Print() {}
+
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t* buffer, size_t size);
+	size_t write(const char* text);
+
+	size_t print(const char* text);
+	size_t print(char c);
+	size_t print(unsigned char n, int base = DEC);
+	size_t print(int n, int base = DEC);
+	size_t print(unsigned int n, int base = DEC);
+	size_t print(long n, int base = DEC);
+	size_t print(unsigned long n, int base = DEC);
+
+	size_t println(void);
+	size_t println(const char* text);
+	size_t println(char c);
+	size_t println(unsigned char n, int base = DEC);
+	size_t println(int n, int base = DEC);
+	size_t println(unsigned int n, int base = DEC);
+	size_t println(long n, int base = DEC);
+	size_t println(unsigned long n, int base = DEC);
+
+private:
+	size_t printNumber(unsigned long n, int base);
+};
+
+#endif /* HOST_PRINT_H_ */
@@ -0,0 +1,12 @@
+/*
+ * SPI.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host stand-in for the SPI library. Nothing uses it directly.
+ */
+
+#ifndef HOST_SPI_H_
+#define HOST_SPI_H_
+
+#endif /* HOST_SPI_H_ */
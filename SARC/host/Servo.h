@@ -0,0 +1,52 @@
+/*
+ * Servo.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host stand-in for the Arduino Servo library. Each Servo remembers the
+ *  last pulse width and when it was written; HostFindServo() looks one up by
+ *  pin.
+ */
+
+#ifndef HOST_SERVO_H_
+#define HOST_SERVO_H_
+
+#include <stdint.h>
+
+#define MIN_PULSE_WIDTH			544
+#define MAX_PULSE_WIDTH			2400
+#define DEFAULT_PULSE_WIDTH		1500
+#define HOST_MAX_SERVOS			12
+
+class Servo
+{
+public:
+	Servo();
+
+	uint8_t attach(int pin);
+	uint8_t attach(int pin, int min, int max);
+	void detach(void);
+	void write(int value);
+	void writeMicroseconds(int value);
+	int read(void);
+	int readMicroseconds(void);
+	bool attached(void);
+
+	// Host only.
+	int pin(void) const { return _pin; }
+	unsigned long writes(void) const { return _writes; }
+	uint32_t lastWriteMicros(void) const { return _lastWrite; }
+
+private:
+	int _pin;
+	int _min;
+	int _max;
+	int _microseconds;
+	unsigned long _writes;
+	uint32_t _lastWrite;
+};
+
+// The attached Servo on pin, or NULL.
+Servo* HostFindServo(int pin);
+
+#endif /* HOST_SERVO_H_ */
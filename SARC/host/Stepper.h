@@ -0,0 +1,12 @@
+/*
+ * Stepper.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host stand-in for the Stepper library. Nothing uses it yet.
+ */
+
+#ifndef HOST_STEPPER_H_
+#define HOST_STEPPER_H_
+
+#endif /* HOST_STEPPER_H_ */
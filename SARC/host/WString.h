@@ -0,0 +1,23 @@
+/*
+ * WString.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host stand-in for the Arduino String class. SARC doesn't use String (it
+ *  uses fixed buffers), so this is only enough for the includes to work.
+ */
+
+#ifndef HOST_WSTRING_H_
+#define HOST_WSTRING_H_
+
+class String
+{
+public:
+	String(const char* text = "") : _text(text) {}
+	const char* c_str(void) const { return _text; }
+
+private:
+	const char* _text;
+};
+
+#endif /* HOST_WSTRING_H_ */
@@ -0,0 +1,18 @@
+/*
+ * pgmspace.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Host stand-in for avr/pgmspace.h. There is only one address space.
+ */
+
+#ifndef HOST_PGMSPACE_H_
+#define HOST_PGMSPACE_H_
+
+#include <stdint.h>
+
+#define PROGMEM
+#define pgm_read_byte(address)	(*(const uint8_t*)(address))
+#define pgm_read_word(address)	(*(const uint16_t*)(address))
+
+#endif /* HOST_PGMSPACE_H_ */
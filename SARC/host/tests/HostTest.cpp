@@ -0,0 +1,212 @@
+/*
+ * HostTest.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  main() for sarc-test. See HostTest.h.
+ *
+ *  Usage: sarc-test [name]
+ *  	Runs every case, or only the one called name.
+ */
+
+#ifdef SARC_HOST
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "HostTest.h"
+#include "SARC.h"
+#include "HostHal.h"
+
+#define HOST_TEST_MAX_CASES		64
+
+struct Registered
+{
+	const char* name;
+	HostTestFunction function;
+};
+
+static Registered cases[HOST_TEST_MAX_CASES];
+static unsigned int caseCount = 0;
+static bool casePassed = true;
+static bool sketchRunning = false;
+#ifdef USE_ETHERNET
+static int controller = -1;
+#endif
+#ifdef USE_XBEE_API
+static const char* radioName = NULL;
+#endif
+
+HostTestCase::HostTestCase(const char* name, HostTestFunction function)
+{
+	if (caseCount == HOST_TEST_MAX_CASES)
+	{
+		fprintf(stderr, "sarc-test: too many cases, %s dropped\n", name);
+		return;
+	}
+	cases[caseCount].name = name;
+	cases[caseCount].function = function;
+	caseCount++;
+}
+
+bool HostTestCheck(bool passed, const char* text, const char* file, int line)
+{
+	if (!passed)
+	{
+		printf("  %s:%d: CHECK(%s) failed\n", file, line, text);
+		casePassed = false;
+	}
+	return passed;
+}
+
+bool HostTestCheckEqual(long expected, long actual, const char* text, const char* file, int line)
+{
+	if (expected != actual)
+	{
+		printf("  %s:%d: %s is %ld, expected %ld\n", file, line, text, actual, expected);
+		casePassed = false;
+	}
+	return expected == actual;
+}
+
+size_t HostTestFrame(uint8_t* frame, const uint8_t* payload, uint8_t length)
+{
+	uint8_t checksum = length;
+
+	frame[0] = PROTOCOL_FRAME_START;
+	frame[1] = length;
+	for (uint8_t i = 0; i < length; i++)
+	{
+		frame[2 + i] = payload[i];
+		checksum ^= payload[i];
+	}
+	frame[2 + length] = checksum;
+	return length + 3;
+}
+
+unsigned int HostTestFullPayload(uint8_t* payload)
+{
+	unsigned int commands = 0;
+	uint8_t length = 0;
+
+	while (length + 5 <= PROTOCOL_MAX_PAYLOAD - 1)
+	{
+		unsigned int speed = 1600 + length;
+		payload[length++] = CSET_SPEEDS;
+		payload[length++] = (uint8_t) speed;
+		payload[length++] = (uint8_t) (speed >> 8);
+		payload[length++] = (uint8_t) speed;
+		payload[length++] = (uint8_t) (speed >> 8);
+		commands++;
+	}
+	while (length < PROTOCOL_MAX_PAYLOAD)
+	{
+		payload[length++] = CSTEER_CENTER;
+		commands++;
+	}
+	return commands;
+}
+
+void HostTestSketch(void)
+{
+	if (sketchRunning) return;
+	sketchRunning = true;
+	HostClockSetVirtual(true);
+	HostEthernetSetListening(false);
+	#ifdef USE_XBEE_API
+		radioName = HostXBeeOpen();
+	#endif
+	setup();
+}
+
+void HostTestRun(unsigned long microseconds)
+{
+	uint32_t start = micros();
+	while (micros() - start < microseconds)
+	{
+		loop();
+		HostClockAdvance(HOST_TEST_PASS_COST);
+	}
+}
+
+void HostTestIdleToWrap(unsigned long lead)
+{
+	unsigned long left = (uint32_t) (0 - lead) - micros();
+
+	while (left > 0)
+	{
+		unsigned long hop = left < HOST_TEST_IDLE_HOP ? left : HOST_TEST_IDLE_HOP;
+		HostClockAdvance(hop);
+		left -= hop;
+		loop();
+	}
+}
+
+#ifdef USE_XBEE_API
+int HostTestRadio(void)
+{
+	static int radio = -1;
+
+	HostTestSketch();
+	if (radio < 0 && radioName != NULL) radio = open(radioName, O_RDWR | O_NOCTTY | O_NONBLOCK);
+	return radio;
+}
+#endif // USE_XBEE_API
+
+#ifdef USE_ETHERNET
+int HostTestController(void)
+{
+	if (controller < 0)
+	{
+		HostTestSketch();
+		controller = HostEthernetConnect();
+		HostTestRun(HOST_TEST_REPLY_TIME);
+	}
+	return controller;
+}
+
+void HostTestDisconnect(void)
+{
+	if (controller < 0) return;
+	close(controller);
+	controller = -1;
+	HostTestRun(HOST_TEST_REPLY_TIME);
+}
+
+size_t HostTestExchange(const void* data, size_t length, uint8_t* reply, size_t size)
+{
+	int controller = HostTestController();
+	size_t received = 0;
+	ssize_t n;
+
+	if (send(controller, data, length, 0) != (ssize_t) length) return 0;
+	HostTestRun(HOST_TEST_REPLY_TIME);
+	while (received < size && (n = recv(controller, reply + received, size - received, MSG_DONTWAIT)) > 0)
+	{
+		received += (size_t) n;
+	}
+	return received;
+}
+#endif // USE_ETHERNET
+
+int main(int argc, char** argv)
+{
+	unsigned int failed = 0;
+	unsigned int run = 0;
+
+	for (unsigned int i = 0; i < caseCount; i++)
+	{
+		if (argc > 1 && strcmp(argv[1], cases[i].name) != 0) continue;
+
+		casePassed = true;
+		cases[i].function();
+		printf("%-40s %s\n", cases[i].name, casePassed ? "ok" : "FAILED");
+		run++;
+		if (!casePassed) failed++;
+	}
+	printf("%u of %u cases passed\n", run - failed, run);
+	return (int) failed;
+}
+
+#endif // SARC_HOST
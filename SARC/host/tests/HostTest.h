@@ -0,0 +1,93 @@
+/*
+ * HostTest.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  A minimal test harness for the host build ("make test"). Each Test*.cpp
+ *  file in this folder defines its cases with HOST_TEST; sarc-test runs
+ *  every case that was compiled in. Cases that need a particular
+ *  configuration (e.g. USE_UDP) are only compiled in that configuration, and
+ *  "make test" builds and runs sarc-test once per configuration.
+ *
+ *  CHECK() reports a failure and carries on with the case; the exit status
+ *  of sarc-test is the number of failed cases.
+ *
+ *  Cases that need the whole sketch call HostTestSketch() first. It runs
+ *  setup() once per process, on the virtual clock (see HostHal.h), with the
+ *  Ethernet server not listening, or with the fake XBee radio open. The
+ *  sketch's globals are shared by every case after that, so those cases
+ *  should leave the robot stopped.
+ */
+
+#ifndef HOSTTEST_H_
+#define HOSTTEST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "Protocol.h"
+
+typedef void (*HostTestFunction)(void);
+
+// Registers a case. Instances are static; see HOST_TEST.
+class HostTestCase
+{
+public:
+	HostTestCase(const char* name, HostTestFunction function);
+};
+
+#define HOST_TEST(name) \
+	static void name(void); \
+	static HostTestCase name##Case(#name, name); \
+	static void name(void)
+
+#define CHECK(condition) \
+	HostTestCheck((condition), #condition, __FILE__, __LINE__)
+
+#define CHECK_EQUAL(expected, actual) \
+	HostTestCheckEqual((long) (expected), (long) (actual), #actual, __FILE__, __LINE__)
+
+bool HostTestCheck(bool passed, const char* text, const char* file, int line);
+bool HostTestCheckEqual(long expected, long actual, const char* text, const char* file, int line);
+
+// Builds a binary frame (see Protocol.h) around payload, in a buffer of at
+// least HOST_TEST_FRAME_SIZE bytes.
+// @return: The length of the frame.
+size_t HostTestFrame(uint8_t* frame, const uint8_t* payload, uint8_t length);
+// Fills PROTOCOL_MAX_PAYLOAD bytes with commands: CSET_SPEEDS, the speeds
+// creeping up from 1600 to 1625, then CSTEER_CENTER to fill the rest.
+// @return: The number of commands.
+unsigned int HostTestFullPayload(uint8_t* payload);
+
+// Runs setup(), the first time it is called.
+void HostTestSketch(void);
+// Runs loop() for this long, in passes of HOST_TEST_PASS_COST virtual microseconds.
+void HostTestRun(unsigned long microseconds);
+// Idles until micros() is about lead microseconds short of wrapping. The clock
+// jumps up to HOST_TEST_IDLE_HOP at a time, with a pass of loop() after each
+// jump, so no due time falls half the clock's range behind.
+void HostTestIdleToWrap(unsigned long lead);
+
+#ifdef USE_XBEE_API
+// The client's end of the fake radio (see HostHal.h), opened non-blocking.
+// Runs the sketch first.
+int HostTestRadio(void);
+#endif
+
+#ifdef USE_ETHERNET
+// The client in control: the first one connected with HostEthernetConnect(),
+// the first time this is called. Runs the sketch first.
+int HostTestController(void);
+// Closes that connection, if it is open, so someone else can take control.
+void HostTestDisconnect(void);
+// Sends length bytes from the controller, runs loop() for HOST_TEST_REPLY_TIME
+// and returns what came back (up to size bytes).
+size_t HostTestExchange(const void* data, size_t length, uint8_t* reply, size_t size);
+#endif
+
+#define HOST_TEST_FRAME_SIZE	(PROTOCOL_MAX_PAYLOAD + 3)
+#define HOST_TEST_PASS_COST		20UL
+#define HOST_TEST_REPLY_TIME	50000UL
+#define HOST_TEST_IDLE_HOP		1800000000UL	// 30 minutes; less than 2^31
+
+#endif /* HOSTTEST_H_ */
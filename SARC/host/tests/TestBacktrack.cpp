@@ -0,0 +1,197 @@
+/*
+ * TestBacktrack.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  The backtrack state machine (see Backtrack.h and the tasks in SARC.cpp),
+ *  on the virtual clock: the client drives a path and disconnects, and after
+ *  TIME_UNTIL_BACKTRACK the robot retraces it, newest leg first, each for
+ *  as long as it was driven. A client connecting again aborts the replay.
+ *  The timing holds when micros() wraps in the middle of a leg.
+ */
+
+#if defined(SARC_HOST) && defined(USE_ETHERNET) && defined(USE_BACKTRACK)
+
+#include "HostTest.h"
+#include "HostHal.h"
+#include "Protocol.h"
+#include "MotorDefs.h"
+#include "Motor.h"
+#include "State.h"
+#include "Backtrack.h"
+
+extern SARC::RobotMotor* motor;
+extern SARC::StateHistory stateHistory;
+extern SARC::BacktrackEngine backtrack;
+
+#define BACKTRACK_STEP			1000UL		// Microseconds between the checks below
+#define BACKTRACK_WAIT			60000000UL	// Longer than TIME_UNTIL_BACKTRACK
+#define BACKTRACK_TOLERANCE		2000UL		// Two steps, plus the error of a packed duration
+
+typedef struct
+{
+	unsigned int left;
+	unsigned int right;
+	unsigned long duration;		// Microseconds
+} Leg;
+
+// Connects as the controller. A session only takes control once it sends
+// something, so it sends a command that doesn't drive.
+static void TakeControl(void)
+{
+	const uint8_t verbose = CREPLY_VERBOSE;
+	uint8_t reply[32];
+
+	HostTestExchange(&verbose, 1, reply, sizeof(reply));
+}
+
+// Drives the legs as the controller, from a clean history, then stops.
+static void Drive(const Leg* legs, unsigned int count)
+{
+	TakeControl();
+	stateHistory.Clear();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		motor->MoveAbsolute(legs[i].left, legs[i].right);
+		HostTestRun(legs[i].duration);
+	}
+	motor->StopMovement();
+}
+
+// Runs loop() until the backtrack starts (or stops), or the speeds change.
+// @return: how long that took.
+static unsigned long RunUntilChange(unsigned long limit)
+{
+	uint32_t start = micros();
+	bool active = backtrack.IsActive();
+	unsigned int left = motor->GetLeftSpeed();
+	unsigned int right = motor->GetRightSpeed();
+
+	while (micros() - start < limit
+			&& backtrack.IsActive() == active
+			&& motor->GetLeftSpeed() == left
+			&& motor->GetRightSpeed() == right)
+	{
+		HostTestRun(BACKTRACK_STEP);
+	}
+	return micros() - start;
+}
+
+// The speed a leg is replayed at. The AF range has one more step in reverse
+// than forward, so full reverse comes back as full forward.
+static unsigned int Reversed(unsigned int speed)
+{
+	unsigned int reversed = 2 * neutral - speed;
+	return reversed > (unsigned int) forward ? (unsigned int) forward : reversed;
+}
+
+// Checks that the robot is driving the reverse of the leg, for about as long
+// as the leg took.
+static bool CheckReplay(const Leg& leg, unsigned long duration)
+{
+	bool passed = CHECK(backtrack.IsActive());
+
+	passed = CHECK_EQUAL(Reversed(leg.left), motor->GetLeftSpeed()) && passed;
+	passed = CHECK_EQUAL(Reversed(leg.right), motor->GetRightSpeed()) && passed;
+	unsigned long took = RunUntilChange(2 * duration);
+	if (took + BACKTRACK_TOLERANCE < duration || took > duration + BACKTRACK_TOLERANCE)
+	{
+		printf("  a %lu us leg was replayed for %lu us\n", duration, took);
+		passed = false;
+	}
+	return CHECK(passed);
+}
+
+HOST_TEST(BacktrackReplay)
+{
+	const Leg legs[] = {
+		{ forward, forward, 400000UL },
+		{ forward, minimum, 300000UL },
+		{ neutral, neutral, 100000UL },		// Skipped by the replay
+		{ FORWARD_HALF_SPEED, REVERSE_HALF_SPEED, 200000UL }
+	};
+
+	Drive(legs, 4);
+	CHECK(!backtrack.IsActive());
+	HostTestDisconnect();
+
+	// Nothing happens until the client has been gone for a while.
+	CHECK(RunUntilChange(BACKTRACK_WAIT) < BACKTRACK_WAIT);
+	CheckReplay(legs[3], legs[3].duration);
+	CheckReplay(legs[1], legs[1].duration);
+	CheckReplay(legs[0], legs[0].duration);
+
+	// Back at the start: the history is used up and the robot waits.
+	CHECK(!backtrack.IsActive());
+	CHECK(!motor->IsMoving());
+	CHECK_EQUAL(0, stateHistory.GetHistorySize());
+	HostTestRun(BACKTRACK_WAIT);
+	CHECK(!backtrack.IsActive());
+	CHECK(!motor->IsMoving());
+}
+
+HOST_TEST(BacktrackAbort)
+{
+	const Leg legs[] = {
+		{ forward, forward, 500000UL },
+		{ forward, minimum, 500000UL }
+	};
+	const unsigned long retraced = 200000UL;
+
+	Drive(legs, 2);
+	HostTestDisconnect();
+	CHECK(RunUntilChange(BACKTRACK_WAIT) < BACKTRACK_WAIT);
+	CHECK(backtrack.IsActive());
+
+	// Connecting isn't enough; the client has to take control.
+	HostTestController();
+	CHECK(backtrack.IsActive());
+	HostTestRun(retraced - HOST_TEST_REPLY_TIME);
+
+	// The client takes over in the middle of the turn.
+	TakeControl();
+	CHECK(!backtrack.IsActive());
+	CHECK(!motor->IsMoving());
+	CHECK_EQUAL(2, stateHistory.GetHistorySize());
+
+	// What is left of the path is replayed the next time the client is lost.
+	HostTestDisconnect();
+	CHECK(RunUntilChange(BACKTRACK_WAIT) < BACKTRACK_WAIT);
+	CheckReplay(legs[1], legs[1].duration - retraced);
+	CheckReplay(legs[0], legs[0].duration);
+	CHECK(!backtrack.IsActive());
+	CHECK(!motor->IsMoving());
+	CHECK_EQUAL(0, stateHistory.GetHistorySize());
+}
+
+HOST_TEST(BacktrackAcrossWrap)
+{
+	const Leg legs[] = {
+		{ forward, forward, 400000UL },
+		{ forward, minimum, 400000UL }
+	};
+
+	// How long it takes from the start of the drive to the replay.
+	uint32_t start = micros();
+	Drive(legs, 2);
+	HostTestDisconnect();
+	CHECK(RunUntilChange(BACKTRACK_WAIT) < BACKTRACK_WAIT);
+	unsigned long lead = micros() - start;
+	RunUntilChange(BACKTRACK_WAIT);
+	RunUntilChange(BACKTRACK_WAIT);
+	CHECK(!backtrack.IsActive());
+
+	// Again, with the clock wrapping halfway through the first leg replayed.
+	HostTestIdleToWrap(lead + legs[1].duration / 2);
+	Drive(legs, 2);
+	HostTestDisconnect();
+	CHECK(RunUntilChange(BACKTRACK_WAIT) < BACKTRACK_WAIT);
+	start = micros();
+	CheckReplay(legs[1], legs[1].duration);
+	CHECK(micros() < start);
+	CheckReplay(legs[0], legs[0].duration);
+	CHECK(!backtrack.IsActive());
+	CHECK(!motor->IsMoving());
+}
+
+#endif // SARC_HOST && USE_ETHERNET && USE_BACKTRACK
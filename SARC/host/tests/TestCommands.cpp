@@ -0,0 +1,104 @@
+/*
+ * TestCommands.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  ProcessCommand() in SARC.cpp, through a client connected over Ethernet.
+ */
+
+#if defined(SARC_HOST) && defined(USE_ETHERNET)
+
+#include "HostTest.h"
+#include "Protocol.h"
+#include "MotorDefs.h"
+#include "Motor.h"
+#include "Scheduler.h"
+
+extern SARC::RobotMotor* motor;
+extern unsigned int delta;
+
+#define TIMEOUT_WAIT	6000000UL	// Longer than MOVEMENT_TIMEOUT
+#define TIMEOUT_EARLY	4000000UL	// Shorter than MOVEMENT_TIMEOUT
+
+// Sends one binary frame. The client is switched to binary mode first.
+static size_t SendFrame(const uint8_t* payload, uint8_t length, uint8_t* reply, size_t size)
+{
+	uint8_t frame[HOST_TEST_FRAME_SIZE];
+	uint8_t binary = PROTOCOL_MODE_BINARY;
+	size_t frameLength = HostTestFrame(frame, payload, length);
+
+	HostTestExchange(&binary, 1, reply, size);
+	return HostTestExchange(frame, frameLength, reply, size);
+}
+
+HOST_TEST(DeltaRange)
+{
+	const unsigned int largest = SARC::RobotDriver::forward - SARC::RobotDriver::minimum;
+	const uint8_t tooLarge[] = { CSET_DELTA, (uint8_t) (largest + 1), (uint8_t) ((largest + 1) >> 8) };
+	const uint8_t overflow[] = { CSET_DELTA, 0xFF, 0xFF };
+	const uint8_t largestDelta[] = { CSET_DELTA, (uint8_t) largest, (uint8_t) (largest >> 8), CFORWARD };
+	const uint8_t restore[] = { CSET_DELTA, (uint8_t) DELTA, (uint8_t) (DELTA >> 8), CSTOP, CMODE_LEGACY };
+	uint8_t reply[64];
+
+	CHECK(SendFrame(tooLarge, sizeof(tooLarge), reply, sizeof(reply)) >= 2);
+	CHECK_EQUAL(STATUS_BAD_COMMAND, reply[0]);
+	CHECK_EQUAL(CSET_DELTA, reply[1]);
+	CHECK_EQUAL(DELTA, delta);
+
+	CHECK(SendFrame(overflow, sizeof(overflow), reply, sizeof(reply)) >= 2);
+	CHECK_EQUAL(STATUS_BAD_COMMAND, reply[0]);
+	CHECK_EQUAL(DELTA, delta);
+
+	// From a standstill, the largest step is full speed, not a wrapped speed.
+	CHECK_EQUAL(4, SendFrame(largestDelta, sizeof(largestDelta), reply, sizeof(reply)));
+	CHECK_EQUAL(STATUS_OK, reply[0]);
+	CHECK_EQUAL(largest, delta);
+	CHECK_EQUAL(SARC::RobotDriver::forward, motor->GetLeftSpeed());
+	CHECK_EQUAL(SARC::RobotDriver::forward, motor->GetRightSpeed());
+
+	SendFrame(restore, sizeof(restore), reply, sizeof(reply));
+	CHECK(!motor->IsMoving());
+}
+
+HOST_TEST(TaskStats)
+{
+	const uint8_t reset = CLOOP_STATS_RESET;
+	const uint8_t query = CTASK_STATS;
+	uint8_t reply[REPORT_HEADER_SIZE + SCHEDULER_DUMP_SIZE + 1];
+
+	HostTestExchange(&reset, 1, reply, sizeof(reply));
+	size_t length = HostTestExchange(&query, 1, reply, sizeof(reply));
+
+	CHECK(length > REPORT_HEADER_SIZE);
+	CHECK_EQUAL(STATUS_OK, reply[0]);
+	CHECK_EQUAL(CTASK_STATS, reply[1]);
+	uint8_t tasks = reply[REPORT_HEADER_SIZE];
+	CHECK(tasks > 0 && tasks <= SCHEDULER_MAX_TASKS);
+	CHECK_EQUAL(1 + 12 * tasks, reply[2]);
+	CHECK_EQUAL(REPORT_HEADER_SIZE + reply[2], length);
+
+	// The intake task runs on every pass, and the count started at the reset.
+	const uint8_t* intake = reply + REPORT_HEADER_SIZE + 1;
+	unsigned long runs = intake[0] | ((unsigned long) intake[1] << 8)
+						 | ((unsigned long) intake[2] << 16) | ((unsigned long) intake[3] << 24);
+	CHECK(runs > 0);
+	CHECK(runs <= HOST_TEST_REPLY_TIME / HOST_TEST_PASS_COST + 1);
+	CHECK(intake[4] | (intake[5] << 8));	// Budget
+}
+
+// The movement timeout is a deadline on micros(), which wraps in the middle.
+HOST_TEST(MovementTimeoutAcrossWrap)
+{
+	const uint8_t verbose = CREPLY_VERBOSE;
+	uint8_t reply[32];
+
+	HostTestExchange(&verbose, 1, reply, sizeof(reply));	// Takes control
+	HostTestIdleToWrap(TIMEOUT_EARLY / 2);
+	motor->MoveAbsolute(SARC::RobotDriver::forward, SARC::RobotDriver::forward);
+	HostTestRun(TIMEOUT_EARLY);
+	CHECK(motor->IsMoving());
+	HostTestRun(TIMEOUT_WAIT - TIMEOUT_EARLY);
+	CHECK(!motor->IsMoving());
+}
+
+#endif // SARC_HOST && USE_ETHERNET
@@ -0,0 +1,91 @@
+/*
+ * TestMotor.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  How far apart the two tracks change, through Motor's own update path, on
+ *  the virtual clock. Each stand-in (Servo, AF_DCMotor and the latch, or
+ *  MockMotorDriver) stamps a track when it is set; the skew of an update is
+ *  the difference between the two stamps. Reported, and checked against the
+ *  cost of one device write (see HostHal.h).
+ */
+
+#ifdef SARC_HOST
+
+#include "HostTest.h"
+#include "HostHal.h"
+#include "MotorDefs.h"
+#include "Motor.h"
+
+extern SARC::RobotMotor* motor;
+
+#if defined(USE_MOCK_MOTORS)
+	#define SKEW_PATH	"Mock"
+	#define SKEW_LIMIT	0UL		// No hardware, so nothing between the tracks.
+#elif defined(USE_SERVOS) && defined(USE_VEX_MOTORS)
+	#define SKEW_PATH	"Vex"
+	#define SKEW_LIMIT	HOST_COST_SERVO_WRITE
+#elif defined(USE_DC_MOTORS) && defined(USE_AF_MOTORS)
+	#define SKEW_PATH	"AF"
+	#define SKEW_LIMIT	HOST_COST_DC_SPEED
+#endif
+
+// When each track was last set.
+static void TrackTimes(uint32_t& left, uint32_t& right)
+{
+	#if defined(USE_MOCK_MOTORS)
+		left = motor->GetDriver().leftTime;
+		right = motor->GetDriver().rightTime;
+	#elif defined(USE_SERVOS) && defined(USE_VEX_MOTORS)
+		left = HostFindServo(PIN_LEFT_SERVO)->lastWriteMicros();
+		right = HostFindServo(PIN_RIGHT_SERVO)->lastWriteMicros();
+	#elif defined(USE_DC_MOTORS) && defined(USE_AF_MOTORS)
+		// A track has changed once both its direction and its duty cycle have.
+		uint32_t latch = HostAFLatchMicros();
+		left = HostFindDCMotor(AF_MOTOR_LEFT)->lastWriteMicros();
+		right = HostFindDCMotor(AF_MOTOR_RIGHT)->lastWriteMicros();
+		if ((int32_t) (latch - left) > 0) left = latch;
+		if ((int32_t) (latch - right) > 0) right = latch;
+	#endif
+}
+
+HOST_TEST(TrackSkew)
+{
+	typedef SARC::RobotDriver Driver;
+	// Every step changes both tracks, and most change a direction.
+	const unsigned int steps[][2] = {
+		{ Driver::forward, Driver::forward },
+		{ Driver::minimum, Driver::minimum },
+		{ (Driver::neutral + Driver::forward) / 2, (Driver::minimum + Driver::neutral) / 2 },
+		{ (Driver::minimum + Driver::neutral) / 2, (Driver::neutral + Driver::forward) / 2 },
+		{ Driver::forward, Driver::minimum },
+		{ Driver::neutral, Driver::neutral }
+	};
+	const unsigned int count = sizeof(steps) / sizeof(steps[0]);
+	unsigned long maxSkew = 0;
+	unsigned long totalSkew = 0;
+
+	HostTestSketch();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		uint32_t left, right;
+
+		HostClockAdvance(1000);
+		uint32_t start = micros();
+		motor->MoveAbsolute(steps[i][0], steps[i][1]);
+		TrackTimes(left, right);
+
+		CHECK((int32_t) (left - start) >= 0);
+		CHECK((int32_t) (right - start) >= 0);
+		unsigned long skew = (int32_t) (left - right) > 0 ? left - right : right - left;
+		if (skew > maxSkew) maxSkew = skew;
+		totalSkew += skew;
+	}
+	printf("  %s skew: %lu us max, %lu us mean over %u updates\n", SKEW_PATH, maxSkew, totalSkew / count, count);
+	CHECK(maxSkew <= SKEW_LIMIT);
+
+	motor->StopMovement();
+	CHECK(!motor->IsMoving());
+}
+
+#endif // SARC_HOST
@@ -0,0 +1,128 @@
+/*
+ * TestProtocol.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  CommandParser (see Protocol.h).
+ */
+
+#ifdef SARC_HOST
+
+#include "HostTest.h"
+#include "Protocol.h"
+
+using namespace SARC;
+
+// Feeds a frame with the given payload, and returns the result of its last byte.
+static ParseResult FeedFrame(CommandParser& parser, const uint8_t* payload, uint8_t length)
+{
+	uint8_t frame[HOST_TEST_FRAME_SIZE];
+	size_t frameLength = HostTestFrame(frame, payload, length);
+
+	for (size_t i = 0; i + 1 < frameLength; i++) parser.Feed(frame[i]);
+	return parser.Feed(frame[frameLength - 1]);
+}
+
+HOST_TEST(LegacyCommands)
+{
+	CommandParser parser;
+	Command command;
+
+	CHECK_EQUAL(parseReady, parser.Feed('w'));
+	CHECK(parser.NextCommand(command));
+	CHECK_EQUAL('w', command.opcode);
+	CHECK(!parser.NextCommand(command));
+	CHECK_EQUAL(parseBadCommand, parser.Feed(CSET_SPEEDS));
+	CHECK(!parser.NextCommand(command));
+}
+
+HOST_TEST(BinaryFrame)
+{
+	CommandParser parser;
+	Command command;
+	const uint8_t payload[] = { CSET_SPEEDS, 0xD0, 0x07, 0xDC, 0x05, CSTEER_CENTER };
+
+	parser.Feed(PROTOCOL_MODE_BINARY);
+	CHECK(parser.NextCommand(command));
+	CHECK_EQUAL(modeBinary, parser.GetMode());
+
+	CHECK_EQUAL(parseReady, FeedFrame(parser, payload, sizeof(payload)));
+	CHECK(parser.NextCommand(command));
+	CHECK_EQUAL(CSET_SPEEDS, command.opcode);
+	CHECK_EQUAL(2000, command.arg1);
+	CHECK_EQUAL(1500, command.arg2);
+	CHECK(parser.NextCommand(command));
+	CHECK_EQUAL(CSTEER_CENTER, command.opcode);
+	CHECK(!parser.NextCommand(command));
+}
+
+HOST_TEST(BadFrames)
+{
+	CommandParser parser;
+	Command command;
+	const uint8_t truncated[] = { CSTEER_CENTER, CSET_DELTA, 0x01 };
+
+	parser.Feed(PROTOCOL_MODE_BINARY);
+	CHECK(parser.NextCommand(command));
+
+	CHECK_EQUAL(parseBadCommand, FeedFrame(parser, truncated, sizeof(truncated)));
+	CHECK(!parser.NextCommand(command));
+
+	parser.Feed(PROTOCOL_FRAME_START);
+	CHECK_EQUAL(parseBadLength, parser.Feed(PROTOCOL_MAX_PAYLOAD + 1));
+
+	parser.Feed(PROTOCOL_FRAME_START);
+	parser.Feed(1);
+	parser.Feed(CSTOP);
+	CHECK_EQUAL(parseBadChecksum, parser.Feed(0));
+	CHECK(!parser.NextCommand(command));
+}
+
+// Commands after CMODE_LEGACY are still binary, arguments and all; only the
+// bytes after the frame are legacy commands.
+HOST_TEST(LegacyModeAfterFrame)
+{
+	CommandParser parser;
+	Command command;
+	const uint8_t payload[] = { CTELEMETRY, 0, 0, CMODE_LEGACY, CSET_SPEEDS, 0x77, 0x05, 0x77, 0x05 };
+
+	parser.Feed(PROTOCOL_MODE_BINARY);
+	CHECK(parser.NextCommand(command));
+
+	CHECK_EQUAL(parseReady, FeedFrame(parser, payload, sizeof(payload)));
+	CHECK(parser.NextCommand(command));
+	CHECK_EQUAL(CTELEMETRY, command.opcode);
+	CHECK(parser.NextCommand(command));
+	CHECK_EQUAL(CMODE_LEGACY, command.opcode);
+	CHECK_EQUAL(modeBinary, parser.GetMode());
+	CHECK(parser.NextCommand(command));
+	CHECK_EQUAL(CSET_SPEEDS, command.opcode);
+	CHECK_EQUAL(0x577, command.arg1);
+	CHECK_EQUAL(0x577, command.arg2);
+	CHECK(!parser.NextCommand(command));
+	CHECK_EQUAL(modeLegacy, parser.GetMode());
+
+	CHECK_EQUAL(parseReady, parser.Feed(CFORWARD));
+	CHECK(parser.NextCommand(command));
+	CHECK_EQUAL(CFORWARD, command.opcode);
+}
+
+// A frame that ends with CMODE_LEGACY switches as soon as it has been read.
+HOST_TEST(LegacyModeLastInFrame)
+{
+	CommandParser parser;
+	Command command;
+	const uint8_t payload[] = { CSTOP, CMODE_LEGACY };
+
+	parser.Feed(PROTOCOL_MODE_BINARY);
+	CHECK(parser.NextCommand(command));
+
+	CHECK_EQUAL(parseReady, FeedFrame(parser, payload, sizeof(payload)));
+	CHECK(parser.NextCommand(command));
+	CHECK(parser.NextCommand(command));
+	CHECK_EQUAL(CMODE_LEGACY, command.opcode);
+	CHECK_EQUAL(modeLegacy, parser.GetMode());
+	CHECK(!parser.NextCommand(command));
+}
+
+#endif // SARC_HOST
@@ -0,0 +1,74 @@
+/*
+ * TestScheduler.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  The Scheduler (see Scheduler.h) on a clock of its own, started just short
+ *  of the point where micros() wraps on the AVR: timers keep their times
+ *  across the wrap.
+ */
+
+#ifdef SARC_HOST
+
+#include "HostTest.h"
+#include "Scheduler.h"
+
+using namespace SARC;
+
+#define WRAP_STEP		100UL		// Microseconds between passes
+#define WRAP_PERIOD		1000UL
+#define WRAP_DELAY		3000UL
+
+static uint32_t now;
+static unsigned int runs;
+static uint32_t ranAt;
+
+static uint32_t Clock(void)
+{
+	return now;
+}
+
+static void Count(void)
+{
+	runs++;
+	ranAt = now;
+}
+
+HOST_TEST(SchedulerPeriodicWraps)
+{
+	Scheduler scheduler(Clock);
+
+	now = 0xFFFFFFFFUL - 5 * WRAP_PERIOD - WRAP_PERIOD / 2;
+	runs = 0;
+	uint8_t task = scheduler.AddPeriodic("Count", Count, WRAP_PERIOD, WRAP_PERIOD);
+	for (unsigned int i = 0; i < 20 * WRAP_PERIOD / WRAP_STEP; i++)
+	{
+		scheduler.RunPending();
+		now += WRAP_STEP;
+	}
+
+	// Once on adding, and once a period after that, before and after the wrap.
+	CHECK_EQUAL(20, runs);
+	CHECK(scheduler.GetStats(task).maxLateness < WRAP_STEP);
+}
+
+HOST_TEST(SchedulerDeadlineWraps)
+{
+	Scheduler scheduler(Clock);
+	uint8_t task = scheduler.AddDeadline("Count", Count, WRAP_PERIOD);
+
+	now = 0xFFFFFFFFUL - WRAP_DELAY / 2;
+	runs = 0;
+	uint32_t armedAt = now;
+	scheduler.Arm(task, WRAP_DELAY);
+	for (unsigned int i = 0; i < 2 * WRAP_DELAY / WRAP_STEP; i++)
+	{
+		scheduler.RunPending();
+		now += WRAP_STEP;
+	}
+
+	CHECK_EQUAL(1, runs);
+	CHECK_EQUAL(WRAP_DELAY, ranAt - armedAt);
+}
+
+#endif // SARC_HOST
@@ -0,0 +1,80 @@
+/*
+ * TestState.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  The bit-packed State (see State.h): speeds over the whole range of the
+ *  driver this build uses (VEX in the vex, udp and xbee builds, AF in the af
+ *  build), and durations against the error bound in State::setDuration().
+ */
+
+#ifdef SARC_HOST
+
+#include "HostTest.h"
+#include "State.h"
+
+using namespace SARC;
+
+HOST_TEST(StateSpeeds)
+{
+	for (unsigned int speed = minimum; speed <= (unsigned int) forward; speed++)
+	{
+		State state(360, 0, speed, 2 * neutral - speed);
+		State reversed;
+
+		if (!CHECK_EQUAL(speed, state.getLeftSpeed())) return;
+		if (!CHECK_EQUAL(2 * neutral - speed, state.getRightSpeed())) return;
+		CHECK_EQUAL(360, state.getDirection());
+
+		state.CopyReverse(reversed);
+		if (!CHECK_EQUAL(2 * neutral - speed, reversed.getLeftSpeed())) return;
+		if (!CHECK_EQUAL(speed, reversed.getRightSpeed())) return;
+	}
+}
+
+// Checks one duration against the bound; false (once reported) if it is off.
+static bool CheckDuration(unsigned long duration)
+{
+	State state(0, duration);
+	unsigned long stored = state.getDuration();
+	unsigned long error = stored > duration ? stored - duration : duration - stored;
+
+	if (duration < (1UL << STATE_MANTISSA_BITS))
+		return CHECK_EQUAL(duration, stored);
+	if (error * 4096 > duration)
+	{
+		printf("  %lu us came back as %lu us\n", duration, stored);
+		return CHECK(error * 4096 <= duration);
+	}
+	return true;
+}
+
+HOST_TEST(StateDurations)
+{
+	unsigned long duration;
+
+	for (duration = 0; duration < (1UL << STATE_MANTISSA_BITS); duration++)
+	{
+		if (!CheckDuration(duration)) return;
+	}
+	// Steps of about 0.1%, and either side of every change of exponent, where
+	// rounding can carry into the next one.
+	for (duration = 1UL << STATE_MANTISSA_BITS; duration < STATE_MAX_DURATION; duration += duration / 1000 + 1)
+	{
+		if (!CheckDuration(duration)) return;
+	}
+	for (uint8_t shift = STATE_MANTISSA_BITS; (1UL << shift) < STATE_MAX_DURATION; shift++)
+	{
+		CheckDuration((1UL << shift) - 1);
+		CheckDuration(1UL << shift);
+		CheckDuration((1UL << shift) + 1);
+	}
+
+	// The example in State.cpp: a 5 second segment is within 1.2 ms.
+	CHECK(CheckDuration(5000000UL));
+	CHECK(CheckDuration(STATE_MAX_DURATION - 1));
+	CHECK_EQUAL(STATE_MAX_DURATION, State(0, STATE_MAX_DURATION).getDuration());
+	CHECK_EQUAL(STATE_MAX_DURATION, State(0, 0xFFFFFFFFUL).getDuration());
+}
+
+#endif // SARC_HOST
@@ -0,0 +1,140 @@
+/*
+ * TestTelemetry.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Who gets the telemetry stream (see Telemetry.h), with a second client
+ *  connected as an observer.
+ */
+
+#if defined(SARC_HOST) && defined(USE_ETHERNET)
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "HostTest.h"
+#include "HostHal.h"
+#include "Protocol.h"
+#include "Telemetry.h"
+
+#define RUN_TIME	500000UL
+
+struct Received
+{
+	unsigned int frames;
+	unsigned int keyframes;
+	unsigned int statusBytes;	// Anything with the high bit set, outside of frames
+	bool firstIsKeyframe;
+};
+
+static void Send(int client, const uint8_t* data, size_t length)
+{
+	send(client, data, length, 0);
+	HostTestRun(HOST_TEST_REPLY_TIME);
+}
+
+static void SendFrame(int client, const uint8_t* payload, uint8_t length)
+{
+	uint8_t frame[HOST_TEST_FRAME_SIZE];
+	Send(client, frame, HostTestFrame(frame, payload, length));
+}
+
+// Switches to binary mode with silent replies, so only reports come back.
+static void MakeSilent(int client)
+{
+	const uint8_t binary = PROTOCOL_MODE_BINARY;
+	const uint8_t silent[] = { CREPLY_SILENT };
+	Send(client, &binary, 1);
+	SendFrame(client, silent, sizeof(silent));
+}
+
+// Reads everything the client has been sent, and picks out the telemetry.
+static Received Read(int client)
+{
+	Received received = { 0, 0, 0, false };
+	uint8_t buffer[4096];
+	ssize_t n;
+	size_t length = 0;
+
+	while (length < sizeof(buffer) && (n = recv(client, buffer + length, sizeof(buffer) - length, MSG_DONTWAIT)) > 0)
+	{
+		length += (size_t) n;
+	}
+
+	for (size_t i = 0; i < length; i++)
+	{
+		// A whole report, with at least up to the FIELDS byte.
+		if (i + REPORT_HEADER_SIZE <= length && buffer[i] == STATUS_OK && buffer[i + 1] == CTELEMETRY
+			&& buffer[i + 2] > TELEMETRY_FIELDS_OFFSET
+			&& i + REPORT_HEADER_SIZE + buffer[i + 2] <= length)
+		{
+			bool keyframe = buffer[i + REPORT_HEADER_SIZE + TELEMETRY_FIELDS_OFFSET] == 0xFF;
+			if (received.frames == 0) received.firstIsKeyframe = keyframe;
+			if (keyframe) received.keyframes++;
+			received.frames++;
+			i += REPORT_HEADER_SIZE + buffer[i + 2] - 1;
+		}
+		else if (buffer[i] & 0x80)
+		{
+			received.statusBytes++;
+		}
+	}
+	return received;
+}
+
+HOST_TEST(TelemetryOnlyToSubscribers)
+{
+	const uint8_t fast[] = { CTELEMETRY, 50, 0 };
+	const uint8_t slow[] = { CTELEMETRY, 100, 0 };
+	const uint8_t off[] = { CTELEMETRY, 0, 0 };
+	const uint8_t legacy[] = { CREPLY_VERBOSE, CMODE_LEGACY };
+	const uint8_t verbose = CREPLY_VERBOSE;
+
+	int controller = HostTestController();
+	int observer = HostEthernetConnect();
+	Send(observer, &verbose, 1);
+	MakeSilent(controller);
+	Read(controller);
+	Read(observer);
+
+	// A text client doesn't get binary frames it didn't ask for.
+	SendFrame(controller, slow, sizeof(slow));
+	HostTestRun(RUN_TIME);
+	Received received = Read(controller);
+	CHECK(received.frames >= RUN_TIME / 100000UL - 1);
+	CHECK(received.firstIsKeyframe);
+	received = Read(observer);
+	CHECK_EQUAL(0, received.frames);
+	CHECK_EQUAL(0, received.statusBytes);
+
+	// A client that joins starts with a keyframe.
+	MakeSilent(observer);
+	Read(controller);
+	SendFrame(observer, fast, sizeof(fast));
+	HostTestRun(RUN_TIME);
+	received = Read(observer);
+	CHECK(received.frames >= RUN_TIME / 50000UL - 1);
+	CHECK(received.firstIsKeyframe);
+	received = Read(controller);
+	CHECK(received.frames >= RUN_TIME / 50000UL - 1);
+	CHECK(received.firstIsKeyframe);
+
+	// Each client stops its own stream.
+	SendFrame(controller, off, sizeof(off));
+	Read(controller);
+	HostTestRun(RUN_TIME);
+	CHECK_EQUAL(0, Read(controller).frames);
+	CHECK(Read(observer).frames > 0);
+
+	SendFrame(observer, legacy, sizeof(legacy));
+	Read(observer);
+	HostTestRun(RUN_TIME);
+	CHECK_EQUAL(0, Read(observer).frames);
+
+	SendFrame(controller, legacy, sizeof(legacy));
+	close(observer);
+	HostTestRun(HOST_TEST_REPLY_TIME);
+	Read(controller);
+}
+
+#endif // SARC_HOST && USE_ETHERNET
@@ -0,0 +1,209 @@
+/*
+ * TestUdp.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Command datagrams (USE_UDP, see Connection.h), sent to the EthernetUDP
+ *  stand-in from a socket in this process.
+ */
+
+#if defined(SARC_HOST) && defined(USE_UDP)
+
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "HostTest.h"
+#include "HostHal.h"
+#include "Connection.h"
+#include "MotorDefs.h"
+#include "Motor.h"
+
+extern SARC::RobotMotor* motor;
+
+static int udp = -1;
+
+// Sends one datagram and runs loop() long enough to handle it.
+static void Send(uint16_t sequence, const uint8_t* commands, size_t length)
+{
+	uint8_t datagram[HOST_UDP_MAX_PACKET];
+	struct sockaddr_in address;
+
+	datagram[0] = (uint8_t) sequence;
+	datagram[1] = (uint8_t) (sequence >> 8);
+	memcpy(datagram + 2, commands, length);
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(HostEthernetUdpPort());
+	sendto(udp, datagram, length + 2, 0, (struct sockaddr*) &address, sizeof(address));
+	HostTestRun(HOST_TEST_REPLY_TIME);
+}
+
+static void SendFrame(uint16_t sequence, const uint8_t* payload, uint8_t length)
+{
+	uint8_t frame[HOST_TEST_FRAME_SIZE];
+	Send(sequence, frame, HostTestFrame(frame, payload, length));
+}
+
+// Reads the next reply datagram.
+// @return: Its length, 0 if there is none.
+static size_t Reply(uint8_t* reply, size_t size)
+{
+	ssize_t n = recv(udp, reply, size, MSG_DONTWAIT);
+	return n > 0 ? (size_t) n : 0;
+}
+
+static void Drain(void)
+{
+	uint8_t reply[HOST_UDP_MAX_PACKET];
+	while (Reply(reply, sizeof(reply)) > 0) {}
+}
+
+// Opens the UDP session in control, in binary mode, starting at sequence.
+static void Open(uint16_t sequence)
+{
+	const uint8_t binary = PROTOCOL_MODE_BINARY;
+
+	HostTestSketch();
+	HostTestDisconnect();	// Nobody else may be in control.
+	if (udp < 0) udp = socket(AF_INET, SOCK_DGRAM, 0);
+	Send(sequence, &binary, 1);
+	Drain();
+}
+
+// Stops the robot, and lets the session time out for the next case.
+static void Close(uint16_t sequence)
+{
+	const uint8_t stop[] = { CSTOP };
+
+	SendFrame(sequence, stop, sizeof(stop));
+	Drain();
+	HostTestRun(CONNECTION_UDP_TIMEOUT * 1000UL);
+}
+
+HOST_TEST(UdpOutOfOrder)
+{
+	const uint8_t forward[] = { CSET_SPEEDS, 0xD0, 0x07, 0xD0, 0x07 };
+	const uint8_t reverse[] = { CSET_SPEEDS, 0xE8, 0x03, 0xE8, 0x03 };
+	uint8_t reply[HOST_UDP_MAX_PACKET];
+
+	Open(100);
+	SendFrame(102, forward, sizeof(forward));
+	CHECK_EQUAL(4, Reply(reply, sizeof(reply)));
+	CHECK_EQUAL(102, reply[0] | (reply[1] << 8));
+	CHECK_EQUAL(STATUS_OK, reply[2]);
+	CHECK_EQUAL(CSET_SPEEDS, reply[3]);
+	CHECK_EQUAL(2000, motor->GetLeftSpeed());
+
+	// Late: sent before 102, so it must not undo it.
+	SendFrame(101, reverse, sizeof(reverse));
+	CHECK_EQUAL(0, Reply(reply, sizeof(reply)));
+	CHECK_EQUAL(2000, motor->GetLeftSpeed());
+
+	SendFrame(103, reverse, sizeof(reverse));
+	CHECK_EQUAL(4, Reply(reply, sizeof(reply)));
+	CHECK_EQUAL(103, reply[0] | (reply[1] << 8));
+	CHECK_EQUAL(1000, motor->GetLeftSpeed());
+
+	Close(104);
+	CHECK(!motor->IsMoving());
+}
+
+HOST_TEST(UdpDuplicate)
+{
+	const uint8_t forward[] = { CFORWARD };
+	uint8_t reply[HOST_UDP_MAX_PACKET];
+
+	Open(200);
+	SendFrame(201, forward, sizeof(forward));
+	CHECK_EQUAL(4, Reply(reply, sizeof(reply)));
+	unsigned int speed = motor->GetLeftSpeed();
+	CHECK(speed > SARC::RobotDriver::neutral);
+
+	// A duplicate would accelerate a second time.
+	SendFrame(201, forward, sizeof(forward));
+	CHECK_EQUAL(0, Reply(reply, sizeof(reply)));
+	CHECK_EQUAL(speed, motor->GetLeftSpeed());
+
+	Close(202);
+}
+
+HOST_TEST(UdpSequenceWraps)
+{
+	const uint8_t center[] = { CSTEER_CENTER };
+	uint8_t reply[HOST_UDP_MAX_PACKET];
+
+	Open(0xFFFE);
+	SendFrame(0xFFFF, center, sizeof(center));
+	CHECK_EQUAL(4, Reply(reply, sizeof(reply)));
+	SendFrame(1, center, sizeof(center));
+	CHECK_EQUAL(4, Reply(reply, sizeof(reply)));
+	CHECK_EQUAL(1, reply[0] | (reply[1] << 8));
+	SendFrame(0xFFFF, center, sizeof(center));
+	CHECK_EQUAL(0, Reply(reply, sizeof(reply)));
+
+	Close(2);
+}
+
+HOST_TEST(UdpFullSizeDatagram)
+{
+	uint8_t payload[PROTOCOL_MAX_PAYLOAD];
+	uint8_t frame[HOST_TEST_FRAME_SIZE];
+	uint8_t reply[HOST_UDP_MAX_PACKET];
+	unsigned int commands = HostTestFullPayload(payload);
+
+	Open(300);
+	Send(301, frame, HostTestFrame(frame, payload, PROTOCOL_MAX_PAYLOAD));
+	size_t replyLength = Reply(reply, sizeof(reply));
+	CHECK_EQUAL(2 + 2 * commands, replyLength);
+	for (size_t i = 2; i < replyLength; i += 2) CHECK_EQUAL(STATUS_OK, reply[i]);
+	CHECK_EQUAL(1625, motor->GetLeftSpeed());
+
+	Close(302);
+}
+
+// Datagrams too long for the receive buffer are refused as a whole, and
+// don't spoil the next one.
+HOST_TEST(UdpOversizeDatagram)
+{
+	const uint8_t stop[] = { CSTOP };
+	const uint8_t forward[] = { CFORWARD_FULL };
+	uint8_t frame[HOST_TEST_FRAME_SIZE];
+	uint8_t centers[PROTOCOL_MAX_PAYLOAD];
+	uint8_t oversize[CONNECTION_RX_BUFFER + 1];
+	uint8_t reply[HOST_UDP_MAX_PACKET];
+
+	Open(400);
+	SendFrame(401, forward, sizeof(forward));
+	Drain();
+
+	memset(centers, CSTEER_CENTER, sizeof(centers));
+	memset(oversize, CSTEER_CENTER, sizeof(oversize));
+	HostTestFrame(oversize, centers, PROTOCOL_MAX_PAYLOAD);
+	Send(402, oversize, sizeof(oversize));
+	CHECK(Reply(reply, sizeof(reply)) > 4);
+	CHECK_EQUAL(402, reply[0] | (reply[1] << 8));
+	CHECK_EQUAL(STATUS_BAD_LENGTH, reply[2]);
+
+	SendFrame(403, stop, sizeof(stop));
+	CHECK_EQUAL(4, Reply(reply, sizeof(reply)));
+	CHECK_EQUAL(STATUS_OK, reply[2]);
+	CHECK_EQUAL(CSTOP, reply[3]);
+	CHECK(!motor->IsMoving());
+
+	// Half a frame, then a whole one: the half is forgotten.
+	SendFrame(404, forward, sizeof(forward));
+	Drain();
+	Send(405, frame, HostTestFrame(frame, forward, sizeof(forward)) - 1);
+	CHECK_EQUAL(0, Reply(reply, sizeof(reply)));
+	SendFrame(406, stop, sizeof(stop));
+	CHECK_EQUAL(4, Reply(reply, sizeof(reply)));
+	CHECK_EQUAL(CSTOP, reply[3]);
+	CHECK(!motor->IsMoving());
+
+	Close(407);
+}
+
+#endif // SARC_HOST && USE_UDP
@@ -0,0 +1,226 @@
+/*
+ * TestXBee.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  The XBee link in API mode (USE_XBEE_API, see Connection.h), through the
+ *  fake radio and its pseudo-terminal (see HostHal.h).
+ */
+
+#if defined(SARC_HOST) && defined(USE_XBEE_API)
+
+#include <string.h>
+#include <unistd.h>
+#include "HostTest.h"
+#include "HostHal.h"
+#include "Connection.h"
+#include "MotorDefs.h"
+#include "Motor.h"
+
+extern SARC::RobotMotor* motor;
+extern bool clientConnected;
+
+#define RADIO_BUFFER	1024
+
+// Sends data as one packet from the remote radio, and runs loop() long
+// enough to handle it.
+static void Send(const uint8_t* data, size_t length)
+{
+	if (write(HostTestRadio(), data, length) != (ssize_t) length) perror("TestXBee: write");
+	HostTestRun(HOST_TEST_REPLY_TIME);
+}
+
+static void SendText(const char* text)
+{
+	Send((const uint8_t*) text, strlen(text));
+}
+
+static void SendFrame(const uint8_t* payload, uint8_t length)
+{
+	uint8_t frame[HOST_TEST_FRAME_SIZE];
+	Send(frame, HostTestFrame(frame, payload, length));
+}
+
+// Everything that has come out at the remote radio.
+static size_t Read(uint8_t* buffer)
+{
+	size_t length = 0;
+	ssize_t n;
+
+	while (length < RADIO_BUFFER && (n = read(HostTestRadio(), buffer + length, RADIO_BUFFER - length)) > 0)
+	{
+		length += (size_t) n;
+	}
+	return length;
+}
+
+static void Drain(void)
+{
+	uint8_t buffer[RADIO_BUFFER];
+	Read(buffer);
+}
+
+static unsigned int CountLines(const char* line)
+{
+	uint8_t buffer[RADIO_BUFFER + 1];
+	size_t length = Read(buffer);
+	unsigned int count = 0;
+
+	buffer[length] = '\0';
+	for (const char* found = (const char*) buffer; (found = strstr(found, line)) != NULL; found++) count++;
+	return count;
+}
+
+// A receive packet from HOST_XBEE_REMOTE, as the radio would send it over the UART.
+// @return: Its length.
+static size_t ReceivePacket(uint8_t* packet, uint8_t data)
+{
+	const uint8_t frame[] = { XBEE_API_RX_16, (uint8_t) (HOST_XBEE_REMOTE >> 8), (uint8_t) HOST_XBEE_REMOTE, 40, 0, data };
+	uint8_t sum = 0;
+
+	packet[0] = XBEE_START;
+	packet[1] = 0;
+	packet[2] = sizeof(frame);
+	for (size_t i = 0; i < sizeof(frame); i++)
+	{
+		packet[3 + i] = frame[i];
+		sum += frame[i];
+	}
+	packet[3 + sizeof(frame)] = 0xFF - sum;
+	return 4 + sizeof(frame);
+}
+
+HOST_TEST(XBeeBaudNegotiation)
+{
+	HostTestSketch();
+	CHECK_EQUAL(XBEE_API_BAUD, HostSerialBaud());
+	CHECK_EQUAL(XBEE_API_BAUD, HostXBeeBaud());
+
+	Drain();
+	SendText("c");
+	CHECK_EQUAL(1, CountLines("Centering.\r\n"));
+}
+
+HOST_TEST(XBeeChecksumErrors)
+{
+	uint8_t packet[16];
+	size_t length;
+
+	HostTestSketch();
+	length = ReceivePacket(packet, CFORWARD_FULL);
+	packet[length - 1] ^= 0x01;
+	HostSerialInject(packet, length);
+	HostTestRun(HOST_TEST_REPLY_TIME);
+	CHECK(!motor->IsMoving());
+
+	packet[length - 1] ^= 0x01;
+	HostSerialInject(packet, length);
+	HostTestRun(HOST_TEST_REPLY_TIME);
+	CHECK(motor->IsMoving());
+	SendText("q");
+	CHECK(!motor->IsMoving());
+
+	// Line noise only ever costs whole packets: a flipped bit never turns
+	// into another command.
+	Drain();
+	HostXBeeSetNoise(40);
+	unsigned int centered = 0;
+	for (unsigned int i = 0; i < 100; i++)
+	{
+		SendText("c");
+		CHECK(!motor->IsMoving());
+		centered += CountLines("Centering.\r\n");
+	}
+	HostXBeeSetNoise(0);
+	CHECK(centered < 100);
+	CHECK(centered > 0);
+}
+
+// Frame bytes that the radio has to escape, both ways.
+HOST_TEST(XBeeEscapes)
+{
+	const uint8_t binary = PROTOCOL_MODE_BINARY;
+	const uint8_t escaped[] = { CREPLY_SILENT, CSET_SPEEDS, XBEE_START, 0x07, XBEE_ESCAPE, 0x07 };
+	const uint8_t flowControl[] = { CSET_SPEEDS, XBEE_XON, 0x07, XBEE_XOFF, 0x07, CTELEMETRY, 50, 0 };
+	const uint8_t done[] = { CTELEMETRY, 0, 0, CSTOP, CREPLY_VERBOSE, CMODE_LEGACY };
+	uint8_t buffer[RADIO_BUFFER];
+
+	Send(&binary, 1);
+	SendFrame(escaped, sizeof(escaped));
+	CHECK_EQUAL(0x77E, motor->GetLeftSpeed());
+	CHECK_EQUAL(0x77D, motor->GetRightSpeed());
+
+	Read(buffer);
+	SendFrame(flowControl, sizeof(flowControl));
+	CHECK_EQUAL(0x711, motor->GetLeftSpeed());
+	CHECK_EQUAL(0x713, motor->GetRightSpeed());
+
+	// The first telemetry frame has every field; the speeds come first.
+	size_t length = Read(buffer);
+	CHECK(length >= REPORT_HEADER_SIZE + 10);
+	if (length >= REPORT_HEADER_SIZE + 10)
+	{
+		CHECK_EQUAL(STATUS_OK, buffer[0]);
+		CHECK_EQUAL(CTELEMETRY, buffer[1]);
+		CHECK_EQUAL(0xFF, buffer[REPORT_HEADER_SIZE + 5]);
+		CHECK_EQUAL(XBEE_XON, buffer[REPORT_HEADER_SIZE + 6]);
+		CHECK_EQUAL(XBEE_XOFF, buffer[REPORT_HEADER_SIZE + 8]);
+	}
+
+	SendFrame(done, sizeof(done));
+	CHECK(!motor->IsMoving());
+	Read(buffer);
+}
+
+HOST_TEST(XBeeFullSizePacket)
+{
+	const uint8_t binary = PROTOCOL_MODE_BINARY;
+	const uint8_t stop[] = { CSTOP, CREPLY_VERBOSE, CMODE_LEGACY };
+	uint8_t payload[PROTOCOL_MAX_PAYLOAD];
+	uint8_t frame[CONNECTION_RX_BUFFER + 1];
+	uint8_t buffer[RADIO_BUFFER];
+	unsigned int commands = HostTestFullPayload(payload);
+	size_t length = HostTestFrame(frame, payload, PROTOCOL_MAX_PAYLOAD);
+
+	Send(&binary, 1);
+	Read(buffer);
+	Send(frame, length);
+	CHECK_EQUAL(2 * commands, Read(buffer));
+	CHECK_EQUAL(1625, motor->GetLeftSpeed());
+
+	// One byte more than fits is refused, not cut short.
+	memset(frame + length, CSTEER_CENTER, sizeof(frame) - length);
+	Send(frame, sizeof(frame));
+	CHECK(Read(buffer) > 2);
+	CHECK_EQUAL(STATUS_BAD_LENGTH, buffer[0]);
+
+	SendFrame(stop, sizeof(stop));
+	CHECK(!motor->IsMoving());
+	Read(buffer);
+}
+
+// Unacknowledged packets count as a lost client, until something gets through.
+HOST_TEST(XBeeDeliveryStatus)
+{
+	const uint8_t binary = PROTOCOL_MODE_BINARY;
+	const uint8_t start[] = { CREPLY_SILENT, CTELEMETRY, 50, 0, CFORWARD_FULL };
+	const uint8_t done[] = { CTELEMETRY, 0, 0, CSTOP, CREPLY_VERBOSE, CMODE_LEGACY };
+	uint8_t buffer[RADIO_BUFFER];
+
+	Send(&binary, 1);
+	SendFrame(start, sizeof(start));
+	CHECK(motor->IsMoving());
+	CHECK(clientConnected);
+
+	HostXBeeSetLoss(100);
+	HostTestRun(2000000UL);
+	CHECK(!clientConnected);
+	CHECK(!motor->IsMoving());
+
+	HostXBeeSetLoss(0);
+	SendFrame(done, sizeof(done));
+	CHECK(clientConnected);
+	Read(buffer);
+}
+
+#endif // SARC_HOST && USE_XBEE_API
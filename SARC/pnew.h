@@ -8,6 +8,8 @@
 #ifndef PNEW_H_
 #define PNEW_H_
 
+#include <stddef.h>
+
 void* operator new(size_t size_,void *ptr_);
 
 